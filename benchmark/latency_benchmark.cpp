@@ -0,0 +1,284 @@
+// Per-call latency distribution of the public logging calls. Every call is
+// timed with the CPU cycle counter and recorded in a log-linear histogram,
+// so rare stalls (rotation, retention, stack traces, lock hand-offs) show up
+// in the high percentiles instead of disappearing in a mean.
+//
+//   DebugLogLatencyBenchmark [--iterations N] [--threads N] [--async]
+//                            [--console] [--scenario NAME]... [--output FILE]
+//
+// A table goes to stderr, a JSON report to stdout or FILE.
+
+#include <DebugLog.h>
+#include <DebugLogSinks.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+    uint64_t ReadCycles() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // Nanoseconds per cycle counter tick.
+    double CalibrateCycles() {
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t startCycles = ReadCycles();
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(200)) { }
+        const uint64_t cycles = ReadCycles() - startCycles;
+        const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return cycles == 0 ? 1.0 : nanoseconds / static_cast<double>(cycles);
+    }
+
+    // Log-linear buckets in the style of HdrHistogram: exact below 128,
+    // then 64 buckets per power of two, i.e. within 1.6% of the value.
+    class Histogram {
+    public:
+        void Record(const uint64_t value) {
+            m_counts[Index(value)]++;
+            m_count++;
+            m_sum += value;
+            m_max = std::max(m_max, value);
+        }
+
+        void Merge(const Histogram& other) {
+            for (size_t i = 0; i < kBuckets; ++i) m_counts[i] += other.m_counts[i];
+            m_count += other.m_count;
+            m_sum += other.m_sum;
+            m_max = std::max(m_max, other.m_max);
+        }
+
+        uint64_t Percentile(const double percentile) const {
+            const auto rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(m_count));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBuckets; ++i) {
+                seen += m_counts[i];
+                if (seen > rank) return std::min(UpperBound(i), m_max);
+            }
+            return m_max;
+        }
+
+        uint64_t Count() const { return m_count; }
+        uint64_t Max() const { return m_max; }
+        double Mean() const { return m_count == 0 ? 0.0 : static_cast<double>(m_sum) / static_cast<double>(m_count); }
+
+    private:
+        static unsigned HighestBit(const uint64_t value) {
+#if defined(_MSC_VER)
+            unsigned long bit;
+            _BitScanReverse64(&bit, value);
+            return static_cast<unsigned>(bit);
+#else
+            return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+        }
+
+        static constexpr unsigned kLinear = 128;
+        static constexpr unsigned kSubBuckets = 64;
+        static constexpr size_t kBuckets = kLinear + 58 * kSubBuckets;
+
+        static size_t Index(const uint64_t value) {
+            if (value < kLinear) return static_cast<size_t>(value);
+
+            const unsigned shift = HighestBit(value) - 6u;
+            return kLinear + (shift - 1) * kSubBuckets + static_cast<size_t>((value >> shift) - kSubBuckets);
+        }
+
+        static uint64_t UpperBound(const size_t index) {
+            if (index < kLinear) return index;
+
+            const size_t shift = (index - kLinear) / kSubBuckets + 1;
+            const uint64_t sub = (index - kLinear) % kSubBuckets + kSubBuckets;
+            return ((sub + 1) << shift) - 1;
+        }
+
+        std::array<uint64_t, kBuckets> m_counts{};
+        uint64_t                       m_count = 0;
+        uint64_t                       m_sum = 0;
+        uint64_t                       m_max = 0;
+    };
+
+    struct Scenario {
+        const char*                           name;
+        size_t                                iterations; // per thread, at --iterations 100000
+        unsigned                              threads;    // 0 for --threads
+        std::function<void(Debug::Settings&)> configure;
+        std::function<void(size_t)>           call;
+    };
+
+    struct Options {
+        size_t                   iterations = 100000;
+        unsigned                 threads = std::max(2u, std::thread::hardware_concurrency());
+        bool                     asynchronous = false;
+        bool                     console = false;
+        std::vector<std::string> scenarios;
+        std::string              output;
+    };
+
+    std::vector<Scenario> CreateScenarios() {
+        return {
+            {"plain", 100000, 1, nullptr, [](size_t) { Debug::Log("Test message"); }},
+            {"formatted", 100000, 1, nullptr, [](const size_t i) { Debug::Log("Value: {} of {} at {:.3f}", i, "formatted", 3.14159); }},
+            {"warning_stacktrace", 10000, 1, nullptr, [](size_t) { Debug::LogWarning("Warning message"); }},
+            {"rotation", 100000, 1,
+             [](Debug::Settings& settings) {
+                 settings.maxFileSize = 64 * 1024;
+                 settings.maxLogFilesAmount = 20;
+             },
+             [](const size_t i) { Debug::Log("Rotating line number {}", i); }},
+            {"contention", 100000, 0, nullptr, [](const size_t i) { Debug::Log("Contended line number {}", i); }},
+        };
+    }
+
+    Histogram Run(const Scenario& scenario, const size_t iterations, const unsigned threads) {
+        std::vector<Histogram> histograms(threads);
+        std::vector<std::thread> workers;
+
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                Histogram& histogram = histograms[t];
+                for (size_t i = 0; i < iterations; ++i) {
+                    const uint64_t start = ReadCycles();
+                    scenario.call(i);
+                    histogram.Record(ReadCycles() - start);
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+
+        Histogram total;
+        for (const auto& histogram : histograms) total.Merge(histogram);
+        return total;
+    }
+
+    void PrintUsage() {
+        std::fprintf(stderr,
+                     "usage: DebugLogLatencyBenchmark [--iterations N] [--threads N] [--async] [--console]\n"
+                     "                                [--scenario NAME]... [--output FILE]\n"
+                     "scenarios: plain formatted warning_stacktrace rotation contention\n");
+    }
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--iterations" && hasValue) {
+            options.iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--async") {
+            options.asynchronous = true;
+        } else if (argument == "--console") {
+            options.console = true;
+        } else if (argument == "--scenario" && hasValue) {
+            options.scenarios.emplace_back(argv[++i]);
+        } else if (argument == "--output" && hasValue) {
+            options.output = argv[++i];
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (options.iterations == 0 || options.threads == 0) {
+        PrintUsage();
+        return 2;
+    }
+
+    // The terminal would dominate every percentile.
+    if (!options.console) {
+        for (const auto& sink : Debug::GetSinks()) {
+            if (std::dynamic_pointer_cast<Debug::ConsoleSink>(sink)) Debug::RemoveSink(sink);
+        }
+    }
+
+    const double nanosecondsPerCycle = CalibrateCycles();
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "debuglog-latency";
+
+    std::string json = fmt::format("{{\"ns_per_cycle\":{:.6f},\"asynchronous\":{},\"scenarios\":[",
+                                   nanosecondsPerCycle, options.asynchronous);
+    std::fprintf(stderr, "%-20s %8s %10s %10s %10s %10s %10s %12s\n",
+                 "scenario", "threads", "calls", "p50 ns", "p99 ns", "p99.9 ns", "p99.99 ns", "max ns");
+
+    bool first = true;
+    for (const Scenario& scenario : CreateScenarios()) {
+        if (!options.scenarios.empty()
+            && std::find(options.scenarios.begin(), options.scenarios.end(), scenario.name) == options.scenarios.end()) {
+            continue;
+        }
+
+        std::filesystem::remove_all(root);
+        Debug::Settings settings;
+        settings.rootPath = root;
+        settings.asynchronous = options.asynchronous;
+        if (scenario.configure) scenario.configure(settings);
+        Debug::SetSettings(settings);
+
+        const unsigned threads = scenario.threads == 0 ? options.threads : scenario.threads;
+        const size_t iterations = std::max<size_t>(1, scenario.iterations * options.iterations / 100000);
+
+        // Warm up the per-thread buffers, the arena and the first segment.
+        Run(scenario, std::min<size_t>(iterations, 1000), threads);
+        const Histogram histogram = Run(scenario, iterations, threads);
+        Debug::Shutdown();
+
+        auto ns = [nanosecondsPerCycle](const uint64_t cycles) {
+            return static_cast<uint64_t>(static_cast<double>(cycles) * nanosecondsPerCycle);
+        };
+        const uint64_t p50 = ns(histogram.Percentile(50.0));
+        const uint64_t p90 = ns(histogram.Percentile(90.0));
+        const uint64_t p99 = ns(histogram.Percentile(99.0));
+        const uint64_t p999 = ns(histogram.Percentile(99.9));
+        const uint64_t p9999 = ns(histogram.Percentile(99.99));
+        const uint64_t max = ns(histogram.Max());
+        const double mean = histogram.Mean() * nanosecondsPerCycle;
+
+        std::fprintf(stderr, "%-20s %8u %10llu %10llu %10llu %10llu %10llu %12llu\n",
+                     scenario.name, threads, static_cast<unsigned long long>(histogram.Count()),
+                     static_cast<unsigned long long>(p50), static_cast<unsigned long long>(p99),
+                     static_cast<unsigned long long>(p999), static_cast<unsigned long long>(p9999),
+                     static_cast<unsigned long long>(max));
+
+        json += fmt::format("{}{{\"name\":\"{}\",\"threads\":{},\"calls\":{},\"mean_ns\":{:.1f},"
+                            "\"p50_ns\":{},\"p90_ns\":{},\"p99_ns\":{},\"p99_9_ns\":{},\"p99_99_ns\":{},\"max_ns\":{}}}",
+                            first ? "" : ",", scenario.name, threads, histogram.Count(), mean,
+                            p50, p90, p99, p999, p9999, max);
+        first = false;
+    }
+    json += "]}\n";
+
+    std::filesystem::remove_all(root);
+
+    FILE* output = options.output.empty() ? stdout : std::fopen(options.output.c_str(), "w");
+    if (!output) {
+        std::perror("DebugLogLatencyBenchmark: output");
+        return 1;
+    }
+    std::fputs(json.c_str(), output);
+    if (output != stdout) std::fclose(output);
+    return 0;
+}
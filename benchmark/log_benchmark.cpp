@@ -32,6 +32,13 @@ static void BM_Log_Formatted(benchmark::State& state) {
 }
 BENCHMARK(BM_Log_Formatted);
 
+static void BM_LogSite_Formatted(benchmark::State& state) {
+    for (auto _ : state) {
+        DEBUG_LOG("Value: {}", 42);
+    }
+}
+BENCHMARK(BM_LogSite_Formatted);
+
 static void BM_LogWarning_String(benchmark::State& state) {
     for (auto _ : state) {
         Debug::LogWarning("Warning message");
@@ -65,4 +72,21 @@ static void BM_Log_Formatted_MultiThread(benchmark::State& state) {
 }
 BENCHMARK(BM_Log_Formatted_MultiThread)->ThreadRange(1, std::thread::hardware_concurrency());
 
+static void BM_Log_Lazy_Disabled_MultiThread(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        Debug::Settings settings;
+        settings.minLevel = Debug::LogLevel::WARNING_DEBUG_LOG;
+        Debug::SetSettings(settings);
+    }
+    for (auto _ : state) {
+        Debug::Log("Thread {} logging value {}", Debug::Lazy([] {
+            return std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        }), 42);
+    }
+    if (state.thread_index() == 0) {
+        Debug::SetSettings({});
+    }
+}
+BENCHMARK(BM_Log_Lazy_Disabled_MultiThread)->ThreadRange(1, std::thread::hardware_concurrency());
+
 BENCHMARK_MAIN();
@@ -3,109 +3,786 @@
 
 #include <string>
 #include <mutex>
-#include <fstream>
-#include <sstream>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <tuple>
 #include <utility>
 #include <type_traits>
-#include <fmt/core.h>
+#include <fmt/format.h>
 #include <string_view>
 #include <filesystem>
 
+#if (__cplusplus >= 202002L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#include <source_location>
+#define DEBUG_LOG_CALLER_LOCATION_ std::source_location::current()
+#else
+#define DEBUG_LOG_CALLER_LOCATION_ ::Debug::SourceLocation{}
+#endif
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
 #ifndef NO_DISCARD
 #define NO_DISCARD [[nodiscard]]
 #endif
 
 class Debug {
 public:
+    enum class RotationPolicy {
+        SIZE_ROTATION,
+        HOURLY_ROTATION,
+        DAILY_ROTATION,
+        SIZE_OR_HOURLY_ROTATION,
+        SIZE_OR_DAILY_ROTATION
+    };
+
+    enum class LogLevel {
+        DEFAULT_DEBUG_LOG,
+        WARNING_DEBUG_LOG,
+        ERROR_DEBUG_LOG
+    };
+
     struct Settings {
         std::filesystem::path rootPath;
-        size_t                maxFileSize;
-        size_t                maxLogFilesAmount;
-        size_t                deleteLogsAfter;
+        size_t                maxFileSize       = 2 * 1024 * 1024;
+        size_t                maxLogFilesAmount = 10;
+        size_t                deleteLogsAfter   = 60 * 60 * 24 * 7;
+        bool                  asynchronous      = false;
+        size_t                asyncMemoryLimit  = 16 * 1024 * 1024;
+        bool                  flushOnEveryWrite = true;
+        RotationPolicy        rotationPolicy    = RotationPolicy::SIZE_ROTATION;
+        size_t                indexInterval     = 0;
+        size_t                statsInterval     = 0;
+        bool                  sourceLocation    = false;
+        LogLevel              minLevel          = LogLevel::DEFAULT_DEBUG_LOG;
+        std::string           pattern           = "[%L%T] %v";
     };
 
-    static void Log(const std::string_view value) {
-        LogI(std::string(value), DebugLogType_::DEFAULT_DEBUG_LOG);
+    // Counters the logger keeps about itself since the process started.
+    // Per-level arrays are indexed by LogLevel.
+    struct Stats {
+        uint64_t records[3]            = {};
+        uint64_t bytes[3]              = {};
+        uint64_t lockWaitNanoseconds   = 0;
+        uint64_t flushes               = 0;
+        uint64_t rotations             = 0;
+        uint64_t rotationNanoseconds   = 0;
+        uint64_t droppedRecords        = 0;
+        uint64_t queueHighWaterMark    = 0;
+        uint64_t stacktraces           = 0;
+        uint64_t stacktraceNanoseconds = 0;
+    };
+
+    // Where a record was logged: the DEBUG_LOG macros in any standard, the
+    // plain Log calls from C++20 on. The strings are static data of the
+    // program. With STRIP_SOURCE_DIRECTORIES defined, file is reduced to the
+    // file name at compile time.
+    struct SourceLocation {
+        std::string_view file;
+        std::string_view function;
+        uint32_t         line;
+
+        constexpr SourceLocation() : line(0) { }
+        constexpr SourceLocation(const std::string_view file, const std::string_view function, const uint32_t line)
+            : file(StripDirectories(file)), function(function), line(line) { }
+#if (__cplusplus >= 202002L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+        consteval SourceLocation(const std::source_location& location)
+            : SourceLocation(location.file_name(), location.function_name(), location.line()) { }
+#endif
+
+        NO_DISCARD constexpr bool IsKnown() const { return line != 0; }
+
+        static constexpr std::string_view StripDirectories(const std::string_view file) {
+#ifdef STRIP_SOURCE_DIRECTORIES
+            return file.substr(file.find_last_of("/\\") + 1);
+#else
+            return file;
+#endif
+        }
+    };
+
+    class Record;
+    class RecordPtr;
+    class RecordArena;
+    class RecordBatch;
+    class Sink;
+    class ConsoleSink;
+    class FileSink;
+    class FlightRecorderSink;
+    class SharedMemoryRing;
+    class SharedMemorySink;
+    class SocketSink;
+    class LogIndex;
+    class Span;
+    class TraceSink;
+    class LogSite;
+    class Context;
+    class ScopedContext;
+    class ConfigWatcher;
+
+    // False when records at level are dropped at the call site: below
+    // Settings::minLevel, or always with DISABLE_LOGGING. The DEBUG_LOG
+    // macros check it before evaluating their arguments.
+    NO_DISCARD static bool IsEnabled(const LogLevel level) {
+#ifdef DISABLE_LOGGING
+        (void)level;
+        return false;
+#else
+        return level >= m_minLevel.load(std::memory_order_relaxed);
+#endif
+    }
+
+    // An argument computed only if the record is formatted, e.g.
+    // Debug::Log("State: {}", Debug::Lazy([&] { return Dump(state); })).
+    template <typename F>
+    struct LazyArgument {
+        F function;
+    };
+
+    template <typename F>
+    static LazyArgument<F> Lazy(F function) {
+        return {std::move(function)};
     }
-    static void LogWarning(const std::string_view value) {
-        LogI(std::string(value), DebugLogType_::WARNING_DEBUG_LOG);
+
+    static void Log(const std::string_view value, const SourceLocation location = DEBUG_LOG_CALLER_LOCATION_) {
+        LogI(value, LogLevel::DEFAULT_DEBUG_LOG, location);
+    }
+    static void LogWarning(const std::string_view value, const SourceLocation location = DEBUG_LOG_CALLER_LOCATION_) {
+        LogI(value, LogLevel::WARNING_DEBUG_LOG, location);
     }
-    static void LogError(const std::string_view value) {
-        LogI(std::string(value), DebugLogType_::ERROR_DEBUG_LOG);
+    static void LogError(const std::string_view value, const SourceLocation location = DEBUG_LOG_CALLER_LOCATION_) {
+        LogI(value, LogLevel::ERROR_DEBUG_LOG, location);
     }
 
     template <typename T, typename = std::enable_if_t<!std::is_convertible_v<T, std::string_view>>>
-    static void Log(const T& value) {
-        LogI(fmt::format("{}", value), DebugLogType_::DEFAULT_DEBUG_LOG);
+    static void Log(const T& value, const SourceLocation location = DEBUG_LOG_CALLER_LOCATION_) {
+        if (IsEnabled(LogLevel::DEFAULT_DEBUG_LOG)) {
+            LogI(FormatMessage("{}", value), LogLevel::DEFAULT_DEBUG_LOG, location);
+        }
     }
 
     template <typename T, typename = std::enable_if_t<!std::is_convertible_v<T, std::string_view>>>
-    static void LogWarning(const T& value) {
-        LogI(fmt::format("{}", value), DebugLogType_::WARNING_DEBUG_LOG);
+    static void LogWarning(const T& value, const SourceLocation location = DEBUG_LOG_CALLER_LOCATION_) {
+        if (IsEnabled(LogLevel::WARNING_DEBUG_LOG)) {
+            LogI(FormatMessage("{}", value), LogLevel::WARNING_DEBUG_LOG, location);
+        }
     }
 
     template <typename T, typename = std::enable_if_t<!std::is_convertible_v<T, std::string_view>>>
-    static void LogError(const T& value) {
-        LogI(fmt::format("{}", value), DebugLogType_::ERROR_DEBUG_LOG);
+    static void LogError(const T& value, const SourceLocation location = DEBUG_LOG_CALLER_LOCATION_) {
+        if (IsEnabled(LogLevel::ERROR_DEBUG_LOG)) {
+            LogI(FormatMessage("{}", value), LogLevel::ERROR_DEBUG_LOG, location);
+        }
     }
 
 #if (__cplusplus >= 202002L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+    // A format string together with the location of the call it was passed
+    // to; a default argument cannot follow the argument pack.
+    template <typename... Args>
+    struct FormatString_ {
+        template <typename S, std::enable_if_t<std::is_convertible_v<const S&, fmt::string_view>
+                                               && std::is_convertible_v<const S&, fmt::format_string<Args...>>, int> = 0>
+        consteval FormatString_(const S& format, const SourceLocation location = std::source_location::current())
+            : format(format), location(location) { }
+
+        // fmt::runtime(...), checked when the line is formatted.
+        template <typename S, std::enable_if_t<!std::is_convertible_v<const S&, fmt::string_view>
+                                               && std::is_convertible_v<const S&, fmt::format_string<Args...>>, int> = 0>
+        FormatString_(const S& format, const SourceLocation location = std::source_location::current())
+            : format(format), location(location) { }
+
+        fmt::format_string<Args...> format;
+        SourceLocation              location;
+    };
+
     template <typename... Args>
-    static void Log(fmt::format_string<Args...> fmt, Args&&... args) {
-        LogI(fmt::vformat(fmt, fmt::make_format_args(args...)), DebugLogType_::DEFAULT_DEBUG_LOG);
+    static void Log(FormatString_<std::type_identity_t<Args>...> fmt, Args&&... args) {
+        if (IsEnabled(LogLevel::DEFAULT_DEBUG_LOG)) {
+            LogI(FormatMessage(fmt.format, std::forward<Args>(args)...), LogLevel::DEFAULT_DEBUG_LOG, fmt.location);
+        }
     }
 
     template <typename... Args>
-    static void LogWarning(fmt::format_string<Args...> fmt, Args&&... args) {
-        LogI(fmt::vformat(fmt, fmt::make_format_args(args...)), DebugLogType_::WARNING_DEBUG_LOG);
+    static void LogWarning(FormatString_<std::type_identity_t<Args>...> fmt, Args&&... args) {
+        if (IsEnabled(LogLevel::WARNING_DEBUG_LOG)) {
+            LogI(FormatMessage(fmt.format, std::forward<Args>(args)...), LogLevel::WARNING_DEBUG_LOG, fmt.location);
+        }
     }
 
     template <typename... Args>
-    static void LogError(fmt::format_string<Args...> fmt, Args&&... args) {
-        LogI(fmt::vformat(fmt, fmt::make_format_args(args...)), DebugLogType_::ERROR_DEBUG_LOG);
+    static void LogError(FormatString_<std::type_identity_t<Args>...> fmt, Args&&... args) {
+        if (IsEnabled(LogLevel::ERROR_DEBUG_LOG)) {
+            LogI(FormatMessage(fmt.format, std::forward<Args>(args)...), LogLevel::ERROR_DEBUG_LOG, fmt.location);
+        }
     }
 #else
     // Fallback for older C++ standards
     template <typename S, typename... Args>
     static void Log(const S& format_str, Args&&... args) {
-        LogI(fmt::format(format_str, std::forward<Args>(args)...), DebugLogType_::DEFAULT_DEBUG_LOG);
+        if (IsEnabled(LogLevel::DEFAULT_DEBUG_LOG)) {
+            LogI(FormatMessage(format_str, std::forward<Args>(args)...), LogLevel::DEFAULT_DEBUG_LOG);
+        }
     }
 
     template <typename S, typename... Args>
     static void LogWarning(const S& format_str, Args&&... args) {
-        LogI(fmt::format(format_str, std::forward<Args>(args)...), DebugLogType_::WARNING_DEBUG_LOG);
+        if (IsEnabled(LogLevel::WARNING_DEBUG_LOG)) {
+            LogI(FormatMessage(format_str, std::forward<Args>(args)...), LogLevel::WARNING_DEBUG_LOG);
+        }
     }
 
     template <typename S, typename... Args>
     static void LogError(const S& format_str, Args&&... args) {
-        LogI(fmt::format(format_str, std::forward<Args>(args)...), DebugLogType_::ERROR_DEBUG_LOG);
+        if (IsEnabled(LogLevel::ERROR_DEBUG_LOG)) {
+            LogI(FormatMessage(format_str, std::forward<Args>(args)...), LogLevel::ERROR_DEBUG_LOG);
+        }
     }
 #endif
 
+    // Logs through a registered call site; use the DEBUG_LOG macros below.
+    // When every argument is a string, number or enum, the calling thread
+    // only copies the arguments into a compact event, and the line is
+    // formatted when the event is written, i.e. on the writer thread in
+    // asynchronous mode. Warnings and errors are formatted right away along
+    // with their stack trace, and so are char pointers at sites that format
+    // pointers. An event whose arguments fail to format at that point, e.g.
+    // a negative dynamic width, is dropped and counted.
+#if (__cplusplus >= 202002L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+    template <typename... Args>
+    static void LogAt(const LogSite& site, fmt::format_string<Args...> fmt, Args&&... args);
+#else
+    template <typename S, typename... Args>
+    static void LogAt(const LogSite& site, const S& format_str, Args&&... args);
+#endif
+
+    // The format string a call site keeps. Only string literals outlive the
+    // first call; any other format, e.g. a std::string or fmt::runtime, is
+    // left out and formatted right away on every call.
+    template <size_t N>
+    static constexpr std::string_view SiteFormat_(const char (&format)[N]) { return format; }
+    template <typename S>
+    static constexpr std::string_view SiteFormat_(const S&) { return {}; }
+
+    // Routes a line already rendered elsewhere, e.g. by another process, to
+    // the registered sinks without adding a prefix of its own.
+    static void Forward(LogLevel type, std::chrono::system_clock::time_point time, std::string_view text);
+
+    // Settings are an immutable snapshot; SetSettings publishes a new one.
+    // When rootPath stays the same the sinks adopt the new level, limits and
+    // retention in place, without closing their files or stopping the writer
+    // thread. GetSettings never takes the IO lock.
     static void SetSettings(const Settings& settings);
+    NO_DISCARD static std::shared_ptr<const Settings> GetSettings();
     static void Shutdown();
 
+    // Blocks until every record logged before the call is written and the
+    // sinks are flushed. In asynchronous mode the caller takes a ticket and
+    // the writer thread reports it done after its next batch, so neither
+    // producers nor the writer wait for the caller.
+    static void Flush();
+
+#if defined(__cpp_impl_coroutine)
+    class FlushAwaiter_ {
+    public:
+        bool await_ready() {
+            m_ticket = RequestFlush();
+            return m_ticket == 0;
+        }
+
+        bool await_suspend(const std::coroutine_handle<> handle) {
+            return AwaitFlush(m_ticket, [](void* address) { std::coroutine_handle<>::from_address(address).resume(); },
+                              handle.address());
+        }
+
+        void await_resume() const noexcept { }
+
+    private:
+        uint64_t m_ticket = 0;
+    };
+
+    // co_await Debug::FlushAsync() suspends where Flush would block. The
+    // coroutine resumes on a thread the logger keeps for this, never the
+    // writer, so it may call Flush, Shutdown or SetSettings. Coroutines
+    // resumed there run one after another.
+    NO_DISCARD static FlushAwaiter_ FlushAsync() { return {}; }
+#endif
+
+    static void AddSink(const std::shared_ptr<Sink>& sink);
+    static void RemoveSink(const std::shared_ptr<Sink>& sink);
+    NO_DISCARD static std::vector<std::shared_ptr<Sink>> GetSinks();
+    static void DumpFlightRecorder();
+    NO_DISCARD static Stats GetStats();
+
+    // Opt-in handler for SIGSEGV, SIGABRT, SIGBUS, SIGFPE and SIGILL that
+    // writes buffered and queued records plus a raw stack of the crashing
+    // thread to the open segments, then re-raises the signal. Threads that
+    // log, and the writer thread, get an alternate signal stack, so a stack
+    // overflow on one of them is handled too. Does nothing on Windows.
+    static void InstallCrashHandler();
+    static void UninstallCrashHandler();
+
+    static const char* LogTypeToString(LogLevel type);
+
 private:
-    enum class DebugLogType_ {
-        DEFAULT_DEBUG_LOG,
-        WARNING_DEBUG_LOG,
-        ERROR_DEBUG_LOG
+
+    // Messages are formatted into a per-thread buffer that keeps its capacity
+    // between calls, so a steady-state log call does not touch the heap.
+    // The returned view is valid until the next format on the same thread.
+    template <typename... Args>
+    static std::string_view FormatMessage(fmt::format_string<Args...> format_str, Args&&... args) {
+        fmt::memory_buffer& buffer = GetMessageBuffer();
+        buffer.clear();
+        fmt::vformat_to(fmt::appender(buffer), format_str, fmt::make_format_args(args...));
+        return {buffer.data(), buffer.size()};
+    }
+
+    static fmt::memory_buffer& GetMessageBuffer();
+    // Renders the message of a deferred record; see RenderDeferred.
+    using Renderer = void (*)(const Record& record, fmt::memory_buffer& message);
+
+    // Arguments that LogAt copies into a compact event: strings as a length
+    // and their bytes, numbers and enums as they are.
+    template <typename T>
+    static constexpr bool IsPackedString_ = std::is_same_v<std::decay_t<T>, std::string> ||
+                                            std::is_same_v<std::decay_t<T>, std::string_view> ||
+                                            std::is_same_v<std::decay_t<T>, const char*> ||
+                                            std::is_same_v<std::decay_t<T>, char*>;
+    template <typename T>
+    static constexpr bool IsPackable_ = IsPackedString_<T> || std::is_arithmetic_v<std::decay_t<T>> ||
+                                        std::is_enum_v<std::decay_t<T>>;
+    template <typename T>
+    using Unpacked_ = std::conditional_t<IsPackedString_<T>, std::string_view, T>;
+    // Packed as strings, but fmt also formats them as pointers ("{:p}").
+    template <typename T>
+    static constexpr bool IsCharPointer_ = std::is_same_v<std::decay_t<T>, const char*> ||
+                                           std::is_same_v<std::decay_t<T>, char*>;
+
+    template <typename T>
+    static size_t PackedSize(const T& value) {
+        if constexpr (IsPackedString_<T>) {
+            return sizeof(uint32_t) + std::string_view(value).size();
+        } else {
+            return sizeof(T);
+        }
+    }
+
+    template <typename T>
+    static void Pack(char*& out, const T& value) {
+        if constexpr (IsPackedString_<T>) {
+            const std::string_view string(value);
+            const auto size = static_cast<uint32_t>(string.size());
+            std::memcpy(out, &size, sizeof(size));
+            std::memcpy(out + sizeof(size), string.data(), size);
+            out += sizeof(size) + size;
+        } else {
+            std::memcpy(out, &value, sizeof(T));
+            out += sizeof(T);
+        }
+    }
+
+    template <typename T>
+    static Unpacked_<T> Unpack(const char*& in) {
+        if constexpr (IsPackedString_<T>) {
+            uint32_t size;
+            std::memcpy(&size, in, sizeof(size));
+            const std::string_view string(in + sizeof(size), size);
+            in += sizeof(size) + size;
+            return string;
+        } else {
+            T value;
+            std::memcpy(&value, in, sizeof(T));
+            in += sizeof(T);
+            return value;
+        }
+    }
+
+    // Packs into the per-thread message buffer; the view is valid until the
+    // next format on the same thread.
+    template <typename... Args>
+    static std::string_view PackArguments(const Args&... args) {
+        fmt::memory_buffer& buffer = GetMessageBuffer();
+        buffer.resize((size_t{0} + ... + PackedSize(args)));
+        [[maybe_unused]] char* out = buffer.data();
+        (Pack(out, args), ...);
+        return {buffer.data(), buffer.size()};
+    }
+
+    template <typename... Args>
+    static void RenderSite(const Record& record, fmt::memory_buffer& message);
+
+    static void LogI(std::string_view message, LogLevel type, const SourceLocation& location = {}, const LogSite* site = nullptr);
+    static void SubmitPacked(const LogSite& site, std::string_view arguments, Renderer renderer);
+    static void Submit(RecordPtr record);
+    static RecordPtr CreateRecord(std::string_view message, LogLevel type, const SourceLocation& location = {},
+                                  const LogSite* site = nullptr);
+    static RecordPtr AllocateRecord(LogLevel type, std::chrono::system_clock::time_point time,
+                                    std::string_view text, size_t messageOffset, size_t messageSize,
+                                    uint64_t thread = GetThreadId(), std::string_view spanName = {},
+                                    std::chrono::nanoseconds spanDuration = {}, Renderer renderer = nullptr,
+                                    const LogSite* site = nullptr, const SourceLocation& location = {},
+                                    std::shared_ptr<const Context> context = {});
+    static RecordPtr RenderDeferred(const Record& record);
+    // Settings::pattern and sourceLocation, compiled by CompileLayout and
+    // published by SetSettings along with the settings. Prefix is everything
+    // before the message, suffix everything after it.
+    class Layout;
+    static const Layout& GetLayout();
+    static const Layout* CompileLayout(const Settings& settings);
+    // A record takes the layout once and passes it to both, so that a
+    // concurrent SetSettings cannot give it the prefix of one pattern and
+    // the suffix of another.
+    static void FormatPrefix(const Layout& layout, fmt::memory_buffer& line, LogLevel type,
+                             std::chrono::system_clock::time_point time, uint64_t thread, const SourceLocation& location);
+    static void FormatSuffix(const Layout& layout, fmt::memory_buffer& line, LogLevel type,
+                             std::chrono::system_clock::time_point time, uint64_t thread, const SourceLocation& location);
+    static void EndSpan(std::string_view name, LogLevel level, std::chrono::steady_clock::duration duration);
+    static uint64_t GetThreadId();
+    static std::shared_ptr<const Context>& GetCurrentContext();
+    static void DestroyRecord(const Record* record);
+    static void Enqueue(RecordPtr record);
+    static void DispatchLocked(const Record* const* records, size_t count);
+    static void DrainQueueLocked();
+    static void CloseLocked();
+    static void StartWriter();
+    static void StopWriter();
+    static void WriterLoop(size_t generation);
+    static void WriteQueued(uint64_t flushTicket);
+
+    struct FlushWaiter_ {
+        uint64_t ticket;
+        void   (*resume)(void*);
+        void*    address;
     };
 
-    static const char* LogTypeToString(DebugLogType_ type);
-    static void LogI(const std::string& message, DebugLogType_ type);
+    // Returns the ticket to wait for, or 0 after flushing in place when there
+    // is no writer thread to hand the flush to.
+    static uint64_t RequestFlush();
+    // Queues resume(address) for when ticket is done; false if it already is.
+    static bool AwaitFlush(uint64_t ticket, void (*resume)(void*), void* address);
+    static void FlushSinksLocked();
+    static void HandleFatalSignal(int signal) noexcept;
+    // Gives the calling thread an alternate signal stack once the crash
+    // handler is installed.
+    static void InstallAlternateStack();
+    // Publishes m_sinks for HandleFatalSignal, which cannot take m_mutex,
+    // while the crash handler is installed.
+    static void PublishSinksLocked();
     static void Init();
-    static void ClearLogs(const std::filesystem::path& rootPath);
+    static void ClearLogs(const std::filesystem::path& rootPath, std::string_view extension = ".log");
     static std::string GetTimestamp();
+    static std::string_view GetCachedTimestamp(std::chrono::system_clock::time_point now);
     static std::chrono::time_point<std::chrono::system_clock> ParseTimestamp(std::string_view str);
+    static std::string GetSegmentName(std::chrono::system_clock::time_point now, uint64_t sequence);
+    static void ParseSegmentName(std::string_view fileName, std::chrono::system_clock::time_point& time, uint64_t& sequence);
+
+    static std::vector<std::shared_ptr<Sink>> CreateDefaultSinks();
+
+    static void CountRecord(LogLevel type, size_t bytes);
+    static void CountLockWait(std::chrono::steady_clock::duration wait);
+    static void CountStacktrace(std::chrono::steady_clock::duration duration);
+    static void CountFlush();
+    static void CountRotation(std::chrono::steady_clock::duration duration);
+    static void CountDropped(size_t count);
+    static void CountQueueDepth(size_t depth);
+    static void LogStatsLocked();
 
     static std::mutex    m_mutex;
-    static std::ofstream m_fileLogStream;
-    static std::ofstream m_fileLogErrorStream;
-    static size_t        m_currentLogStreamFileSize;
-    static size_t        m_currentLogErrorStreamFileSize;
     static bool          m_initFlag;
-    static Settings      m_settings;
+    static std::shared_ptr<const Settings> m_settings; // written under m_mutex with std::atomic_store
+
+    static std::vector<std::shared_ptr<Sink>> m_sinks;
+    // The sinks as the fatal signal handler sees them: an array that is never
+    // changed or freed once published.
+    static std::atomic<const std::vector<Sink*>*> m_signalSinks;
+
+    static RecordArena                 m_arena;
+    static std::atomic<const Record*>  m_queueHead;
+    static std::atomic<bool>           m_asyncFlag;
+    static std::mutex                  m_queueMutex;
+    static std::condition_variable     m_queueCondition;
+    static std::thread                 m_writerThread;
+    static size_t                      m_writerGeneration;
+
+    // Flush tickets, guarded by m_queueMutex.
+    static uint64_t                    m_flushRequested;
+    static uint64_t                    m_flushCompleted;
+    static std::condition_variable     m_flushCondition;
+    static std::vector<FlushWaiter_>   m_flushWaiters;
+
+    static std::chrono::steady_clock::time_point m_statsDeadline;
+    static std::atomic<LogLevel>                 m_minLevel;
+    static std::atomic<const Layout*>            m_layout;
+};
+
+// Times a scope: logs "<name> took <n> us (thread <id>)" when it ends. The
+// calling thread only reads the clock and queues a compact event; the line
+// is formatted when the event is written, i.e. on the writer thread in
+// asynchronous mode. The name must stay valid until the span ends. Spans
+// carry no stack trace.
+class Debug::Span {
+public:
+    explicit Span(const std::string_view name, const LogLevel level = LogLevel::DEFAULT_DEBUG_LOG)
+        : m_name(name), m_level(level), m_start(std::chrono::steady_clock::now()), m_ended(false) { }
+
+    ~Span() {
+        End();
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    // Ends the span before the scope does. Later calls do nothing.
+    void End() {
+        if (!m_ended) {
+            m_ended = true;
+            EndSpan(m_name, m_level, std::chrono::steady_clock::now() - m_start);
+        }
+    }
+
+private:
+    std::string_view                      m_name;
+    LogLevel                              m_level;
+    std::chrono::steady_clock::time_point m_start;
+    bool                                  m_ended;
+};
+
+// Fields attached to every record a thread logs while a ScopedContext is
+// alive: those of the innermost scope and of every scope around it,
+// outermost first. Rendered once, as "key=value key=value", when the scope
+// is entered; records share the context instead of copying it.
+class Debug::Context {
+public:
+    struct Field {
+        template <typename T>
+        Field(const std::string_view key, const T& value) : key(key), value(fmt::format("{}", value)) { }
+
+        std::string key;
+        std::string value;
+    };
+
+    Context(const Context* parent, std::initializer_list<Field> fields);
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    const std::vector<Field> fields;
+    const std::string        text;
+};
+
+// Pushes fields onto the calling thread's context until the end of the
+// scope, e.g. Debug::ScopedContext context{{"request", id}, {"tenant", name}}.
+class Debug::ScopedContext {
+public:
+    ScopedContext(std::initializer_list<Context::Field> fields);
+    ~ScopedContext();
+
+    ScopedContext(const ScopedContext&) = delete;
+    ScopedContext& operator=(const ScopedContext&) = delete;
+
+private:
+    std::shared_ptr<const Context> m_previous;
+};
+
+// A log statement, registered on its first execution by the DEBUG_LOG
+// macros. The id is compact and stays the same for the life of the process,
+// so that records can refer to their format string and source location
+// instead of carrying them. The format is empty unless the statement passed
+// a string literal.
+class Debug::LogSite {
+public:
+    LogSite(LogLevel level, std::string_view format, const SourceLocation& location);
+
+    LogSite(const LogSite&) = delete;
+    LogSite& operator=(const LogSite&) = delete;
+
+    const uint32_t         id;
+    const LogLevel         level;
+    const std::string_view format;
+    const SourceLocation   location;
+    // The format has a "{:p}" field; char pointers are then not packed as
+    // strings.
+    const bool             formatsPointers;
+
+    // The site registered under id, or nullptr.
+    NO_DISCARD static const LogSite* Find(uint32_t id);
+};
+
+// A single log call: metadata plus the line rendered once, sanitized to valid
+// UTF-8, and shared by every sink without copying. Records are immutable and
+// reference counted; the views stay valid for as long as a RecordPtr to the
+// record exists. The text lives in the same allocation as the record itself.
+class Debug::Record {
+public:
+    Record(const Record&) = delete;
+    Record& operator=(const Record&) = delete;
+
+    const LogLevel                              level;
+    const std::chrono::system_clock::time_point time;
+    const std::string_view                      message;
+    const std::string_view                      text;
+    // OS id of the thread that logged the record.
+    const uint64_t                              thread;
+    // Set on records written by a Debug::Span, which started spanDuration
+    // before time.
+    const std::string_view                      spanName;
+    const std::chrono::nanoseconds              spanDuration;
+    // Set on records logged through the DEBUG_LOG macros.
+    const LogSite* const                        site;
+    const SourceLocation                        location;
+    // Context of the logging thread, if it had one.
+    const std::shared_ptr<const Context>        context;
+
+    NO_DISCARD bool IsSpan() const { return !spanName.empty(); }
+
+private:
+    friend class Debug;
+    friend class RecordPtr;
+
+    Record(LogLevel level, std::chrono::system_clock::time_point time, std::string_view message, std::string_view text,
+           uint64_t thread, std::string_view spanName, std::chrono::nanoseconds spanDuration, const LogSite* site,
+           const SourceLocation& location, std::shared_ptr<const Context> context, Renderer renderer, bool pooled)
+        : level(level), time(time), message(message), text(text), thread(thread), spanName(spanName),
+          spanDuration(spanDuration), site(site), location(location), context(std::move(context)), m_references(1), m_next(nullptr), m_renderer(renderer), m_pooled(pooled) { }
+
+    void AddRef() const {
+        m_references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Release() const {
+        if (m_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            DestroyRecord(this);
+        }
+    }
+
+    mutable std::atomic<uint32_t> m_references;
+    mutable const Record*         m_next;
+    // Set while the record is still a compact event whose line has not been
+    // rendered; sinks never see such records.
+    const Renderer                m_renderer;
+    const bool                    m_pooled;
+};
+
+// Shared ownership of a Record. Sinks that keep records past Write take a
+// RecordPtr to them instead of copying the text.
+class Debug::RecordPtr {
+public:
+    RecordPtr() = default;
+
+    explicit RecordPtr(const Record& record) : m_record(&record) {
+        m_record->AddRef();
+    }
+
+    RecordPtr(const RecordPtr& other) : m_record(other.m_record) {
+        if (m_record) m_record->AddRef();
+    }
+
+    RecordPtr(RecordPtr&& other) noexcept : m_record(other.m_record) {
+        other.m_record = nullptr;
+    }
+
+    RecordPtr& operator=(RecordPtr other) noexcept {
+        std::swap(m_record, other.m_record);
+        return *this;
+    }
+
+    ~RecordPtr() {
+        reset();
+    }
+
+    void reset() {
+        if (m_record) m_record->Release();
+        m_record = nullptr;
+    }
+
+    NO_DISCARD const Record* get() const { return m_record; }
+    const Record* operator->() const { return m_record; }
+    const Record& operator*() const { return *m_record; }
+    explicit operator bool() const { return m_record != nullptr; }
+
+private:
+    friend class Debug;
+
+    struct Adopt_ { };
+
+    RecordPtr(const Record* record, Adopt_) : m_record(record) { }
+
+    const Record* Detach() {
+        const Record* record = m_record;
+        m_record = nullptr;
+        return record;
+    }
+
+    const Record* m_record = nullptr;
+};
+
+#if (__cplusplus >= 202002L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+template <typename... Args>
+void Debug::LogAt(const LogSite& site, fmt::format_string<Args...> fmt, Args&&... args) {
+    if constexpr ((IsPackable_<Args> && ...)) {
+        if (site.level == LogLevel::DEFAULT_DEBUG_LOG && !site.format.empty()
+            && !((IsCharPointer_<Args> || ...) && site.formatsPointers)) {
+            SubmitPacked(site, PackArguments(args...), &RenderSite<std::decay_t<Args>...>);
+            return;
+        }
+    }
+    LogI(FormatMessage(fmt, std::forward<Args>(args)...), site.level, site.location, &site);
+}
+#else
+template <typename S, typename... Args>
+void Debug::LogAt(const LogSite& site, const S& format_str, Args&&... args) {
+    if constexpr ((IsPackable_<Args> && ...)) {
+        if (site.level == LogLevel::DEFAULT_DEBUG_LOG && !site.format.empty()
+            && !((IsCharPointer_<Args> || ...) && site.formatsPointers)) {
+            SubmitPacked(site, PackArguments(args...), &RenderSite<std::decay_t<Args>...>);
+            return;
+        }
+    }
+    LogI(FormatMessage(format_str, std::forward<Args>(args)...), site.level, site.location, &site);
+}
+#endif
+
+template <typename... Args>
+void Debug::RenderSite(const Record& record, fmt::memory_buffer& message) {
+    // Braced initialization unpacks the arguments in order.
+    [[maybe_unused]] const char* in = record.text.data();
+    const std::tuple<Unpacked_<Args>...> arguments{Unpack<Args>(in)...};
+    std::apply([&](const auto&... unpacked) {
+        fmt::vformat_to(fmt::appender(message), fmt::string_view(record.site->format.data(), record.site->format.size()),
+                        fmt::make_format_args(unpacked...));
+    }, arguments);
+}
+
+// Log through a call site registered once, on first execution, with its
+// format string, level and source location. The arguments are only
+// evaluated when the level is enabled.
+#define DEBUG_LOG_AT(level, format, ...)                                                              \
+    do {                                                                                              \
+        if (::Debug::IsEnabled(level)) {                                                              \
+            static constexpr ::Debug::SourceLocation debugLogLocation_(__FILE__, __func__, __LINE__); \
+            static const ::Debug::LogSite debugLogSite_(level, ::Debug::SiteFormat_(format),          \
+                                                        debugLogLocation_);                           \
+            ::Debug::LogAt(debugLogSite_, format, ##__VA_ARGS__);                                     \
+        }                                                                                             \
+    } while (false)
+
+#define DEBUG_LOG(format, ...)         DEBUG_LOG_AT(::Debug::LogLevel::DEFAULT_DEBUG_LOG, format, ##__VA_ARGS__)
+#define DEBUG_LOG_WARNING(format, ...) DEBUG_LOG_AT(::Debug::LogLevel::WARNING_DEBUG_LOG, format, ##__VA_ARGS__)
+#define DEBUG_LOG_ERROR(format, ...)   DEBUG_LOG_AT(::Debug::LogLevel::ERROR_DEBUG_LOG, format, ##__VA_ARGS__)
+
+template <typename F>
+struct fmt::formatter<Debug::LazyArgument<F>> : fmt::formatter<std::decay_t<std::invoke_result_t<const F&>>> {
+    template <typename FormatContext>
+    auto format(const Debug::LazyArgument<F>& argument, FormatContext& context) const {
+        return fmt::formatter<std::decay_t<std::invoke_result_t<const F&>>>::format(argument.function(), context);
+    }
 };
 
 #endif // DEBUG_LOG_H
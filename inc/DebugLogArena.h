@@ -0,0 +1,51 @@
+#ifndef DEBUG_LOG_ARENA_H
+#define DEBUG_LOG_ARENA_H
+
+#include <DebugLog.h>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+// Slab allocator for records that outlive the log call which produced them.
+//
+// Every producer thread bump-allocates from its own slab, so the hot path
+// takes no lock and never calls malloc once the pool is warm. Each slab counts
+// its live blocks; the consumer releases blocks after writing them and a slab
+// returns to the shared pool as soon as its last block is released and its
+// producer has moved on to a fresh slab. The total size of all slabs never
+// exceeds the configured memory limit - Allocate() returns nullptr instead.
+//
+// The arena must outlive every thread that allocates from it.
+class Debug::RecordArena {
+public:
+    static constexpr size_t SlabSize = 64 * 1024;
+
+    explicit RecordArena(size_t memoryLimit);
+    ~RecordArena();
+
+    RecordArena(const RecordArena&) = delete;
+    RecordArena& operator=(const RecordArena&) = delete;
+
+    NO_DISCARD void* Allocate(size_t size);
+    static void Release(void* block);
+
+    void SetMemoryLimit(size_t memoryLimit);
+    NO_DISCARD size_t GetMemoryLimit() const;
+    NO_DISCARD size_t GetReservedBytes() const;
+
+private:
+    struct Slab;
+    struct ThreadSlab;
+
+    static ThreadSlab& GetThreadSlab();
+    NO_DISCARD Slab* AcquireSlab(size_t capacity);
+    void Recycle(Slab* slab);
+    void FreeSlab(Slab* slab);
+
+    mutable std::mutex m_poolMutex;
+    Slab*              m_freeSlabs;
+    size_t             m_memoryLimit;
+    size_t             m_reservedBytes;
+};
+
+#endif // DEBUG_LOG_ARENA_H
@@ -0,0 +1,66 @@
+#ifndef DEBUG_LOG_CONFIG_H
+#define DEBUG_LOG_CONFIG_H
+
+#include <DebugLog.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <mutex>
+#include <thread>
+
+// Applies settings from a text file to the running logger, once when it is
+// created and again whenever the file is written or replaced, so that e.g.
+// minLevel can be changed on a live process. Each line is `name = value` with
+// the name of a Settings field; blank lines and lines starting with '#' are
+// skipped. Levels and rotation policies are spelled like their enumerators,
+// e.g. WARNING_DEBUG_LOG or SIZE_OR_DAILY_ROTATION, and booleans as true or
+// false. Fields missing from the file keep the value they had when the
+// watcher was created. On Linux the directory of the file is watched with
+// inotify; elsewhere its modification time is polled every pollInterval. A
+// file that does not parse is reported with LogWarning and changes nothing.
+class Debug::ConfigWatcher {
+public:
+    static constexpr std::chrono::milliseconds PollInterval = std::chrono::milliseconds(1000);
+
+    explicit ConfigWatcher(std::filesystem::path path, std::chrono::milliseconds pollInterval = PollInterval);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    // Reads a config file on top of base. Throws std::runtime_error naming
+    // the line of an unknown field or an invalid value.
+    NO_DISCARD static Settings Parse(std::istream& input, Settings base);
+
+    NO_DISCARD const std::filesystem::path& GetPath() const;
+
+    // Number of times the file was read and applied.
+    NO_DISCARD uint64_t GetReloadCount() const;
+
+private:
+    void Reload();
+    void WatchLoop();
+    void WatchInotify();
+    void PollModificationTime();
+
+    std::filesystem::path           m_path;
+    Settings                        m_base;
+    std::chrono::milliseconds       m_pollInterval;
+    std::atomic<uint64_t>           m_reloads;
+
+    // inotify descriptor and the pipe that wakes the watcher to stop it, or
+    // -1 when the modification time is polled instead.
+    int                             m_inotify;
+    int                             m_wakeup[2];
+    std::filesystem::file_time_type m_lastWrite;
+
+    std::mutex                      m_mutex;
+    std::condition_variable         m_condition;
+    bool                            m_stopping;
+    std::thread                     m_thread;
+};
+
+#endif // DEBUG_LOG_CONFIG_H
@@ -0,0 +1,57 @@
+#ifndef DEBUG_LOG_INDEX_H
+#define DEBUG_LOG_INDEX_H
+
+#include <DebugLog.h>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+// Time-range reads over the segments written by FileSink. Next to every
+// <name>.log there is a <name>.idx of fixed-size entries, one per
+// Settings::indexInterval bytes of log: the offset at which a record starts
+// and the newest record time written before that offset. Those times never
+// decrease, even when threads log slightly out of order, so the first byte
+// worth reading for a given start time is found by binary search.
+class Debug::LogIndex {
+public:
+    struct Entry {
+        int64_t  maxTimeBefore; // nanoseconds since the epoch
+        uint64_t offset;
+    };
+
+    NO_DISCARD static std::filesystem::path GetIndexPath(const std::filesystem::path& segment);
+    NO_DISCARD static std::vector<Entry> Load(const std::filesystem::path& segment);
+
+    // Offset from which every record logged at or after start is found; 0
+    // when the segment has no index.
+    NO_DISCARD static uint64_t FindOffset(const std::filesystem::path& segment, std::chrono::system_clock::time_point start);
+
+    // Log segments in directory, oldest first.
+    NO_DISCARD static std::vector<std::filesystem::path> ListSegments(const std::filesystem::path& directory);
+
+    // Log segments of every directory below path, each directory oldest
+    // first, or path itself when it is a file. The errors directory of the
+    // default sinks only repeats warnings and errors of the all directory
+    // next to it, so it is left out when both are below path.
+    NO_DISCARD static std::vector<std::filesystem::path> CollectSegments(const std::filesystem::path& path);
+
+    // Calls onRecord with every record in directory whose timestamp lies in
+    // [start, end], in logging order. A record spans all of its lines and
+    // comes without the final newline. Returns the number of records.
+    static size_t ReadRange(const std::filesystem::path& directory,
+                            std::chrono::system_clock::time_point start,
+                            std::chrono::system_clock::time_point end,
+                            const std::function<void(std::string_view)>& onRecord);
+
+    // Parses a local "YYYY-MM-DD_HH-MM-SS" timestamp.
+    static bool ParseTime(std::string_view text, std::chrono::system_clock::time_point& time);
+
+    // Parses the timestamp of a line that starts a record, i.e. one that
+    // begins with "[LEVEL   timestamp]". False for continuation lines.
+    static bool ParseRecordTime(std::string_view line, std::chrono::system_clock::time_point& time);
+};
+
+#endif // DEBUG_LOG_INDEX_H
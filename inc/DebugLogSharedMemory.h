@@ -0,0 +1,101 @@
+#ifndef DEBUG_LOG_SHARED_MEMORY_H
+#define DEBUG_LOG_SHARED_MEMORY_H
+
+#include <DebugLogSinks.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#if !defined(_WIN32)
+
+// Single-producer single-consumer byte ring in a POSIX shared memory object
+// (shm_open + mmap). A process logging through a SharedMemorySink owns one
+// ring; the collector maps every ring it finds and drains them. Entries that
+// do not fit are dropped and counted rather than blocking the producer.
+class Debug::SharedMemoryRing {
+public:
+    struct Entry {
+        LogLevel                              level;
+        std::chrono::system_clock::time_point time;
+        std::string_view                      text;
+    };
+
+    // Creates /<name>, replacing a stale object of the same name. Throws
+    // std::runtime_error on failure.
+    static std::unique_ptr<SharedMemoryRing> Create(const std::string& name, size_t capacity);
+    // Maps an existing ring. Returns nullptr if it is not (yet) a valid ring.
+    static std::unique_ptr<SharedMemoryRing> Attach(const std::string& name);
+
+    ~SharedMemoryRing();
+
+    SharedMemoryRing(const SharedMemoryRing&) = delete;
+    SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+    // Producer side. Push is async-signal-safe.
+    bool Push(LogLevel level, std::chrono::system_clock::time_point time, std::string_view text) noexcept;
+    // Counts entries the producer gave up on without pushing them.
+    void AddDropped(uint64_t count) noexcept;
+    void MarkClosed();
+
+    // Consumer side. The entry's text is valid until the next Pop.
+    bool Pop(Entry& entry);
+
+    void Unlink() const;
+
+    NO_DISCARD const std::string& GetName() const;
+    NO_DISCARD size_t GetCapacity() const;
+    NO_DISCARD int GetProducerPid() const;
+    NO_DISCARD uint64_t GetDroppedCount() const;
+    NO_DISCARD bool IsClosed() const;
+    NO_DISCARD bool IsEmpty() const;
+
+private:
+    struct Header;
+
+    SharedMemoryRing(std::string name, void* memory, size_t mappedSize);
+
+    void Read(uint64_t position, void* out, size_t size) const;
+    void Write(uint64_t position, const void* data, size_t size) noexcept;
+
+    std::string m_name;
+    void*       m_memory;
+    size_t      m_mappedSize;
+    Header*     m_header;
+    char*       m_data;
+    std::string m_scratch;
+};
+
+// Writes records into a SharedMemoryRing named /<channel>.<pid>.<n> instead
+// of doing I/O in this process; run debuglog-collector to write the rings of
+// every process on the host into one set of rotated files. The ring has a
+// single producer: a fatal signal that interrupts a Write drops what the
+// crash handler writes rather than pushing over the unfinished entry.
+class Debug::SharedMemorySink final : public Sink {
+public:
+    explicit SharedMemorySink(std::string channel = "debuglog",
+                              size_t capacity = 4 * 1024 * 1024,
+                              LogLevel minLevel = LogLevel::DEFAULT_DEBUG_LOG);
+    ~SharedMemorySink() override;
+
+    void Open(const Settings& settings) override;
+    void Write(const RecordBatch& records) override;
+    void WriteFromSignal(LogLevel level, std::string_view text) noexcept override;
+
+    NO_DISCARD const std::string& GetRingName() const;
+
+private:
+    std::string                       m_channel;
+    size_t                            m_capacity;
+    std::string                       m_ringName;
+    std::unique_ptr<SharedMemoryRing> m_ring;
+    fmt::memory_buffer                m_line;
+    // Held by whoever is pushing to the ring: Write or the crash handler.
+    std::atomic<bool>                 m_pushing;
+};
+
+#endif // !_WIN32
+
+#endif // DEBUG_LOG_SHARED_MEMORY_H
@@ -0,0 +1,208 @@
+#ifndef DEBUG_LOG_SINKS_H
+#define DEBUG_LOG_SINKS_H
+
+#include <DebugLog.h>
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <iterator>
+#include <vector>
+
+// A contiguous run of records handed to a sink in logging order.
+class Debug::RecordBatch {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = Record;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const Record*;
+        using reference         = const Record&;
+
+        explicit Iterator(const Record* const* current) : m_current(current) { }
+
+        reference operator*() const { return **m_current; }
+        pointer operator->() const { return *m_current; }
+        Iterator& operator++() { ++m_current; return *this; }
+        Iterator operator++(int) { Iterator copy = *this; ++m_current; return copy; }
+        bool operator==(const Iterator& other) const { return m_current == other.m_current; }
+        bool operator!=(const Iterator& other) const { return m_current != other.m_current; }
+
+    private:
+        const Record* const* m_current;
+    };
+
+    RecordBatch(const Record* const* records, const size_t size) : m_records(records), m_size(size) { }
+
+    NO_DISCARD Iterator begin() const { return Iterator(m_records); }
+    NO_DISCARD Iterator end() const { return Iterator(m_records + m_size); }
+    NO_DISCARD size_t size() const { return m_size; }
+    NO_DISCARD bool empty() const { return m_size == 0; }
+    const Record& operator[](const size_t index) const { return *m_records[index]; }
+    NO_DISCARD RecordBatch Slice(const size_t offset, const size_t count) const { return {m_records + offset, count}; }
+
+private:
+    const Record* const* m_records;
+    size_t               m_size;
+};
+
+// Destination for log records. Sinks are registered with Debug::AddSink and
+// every call on them happens under the logger's IO lock, so implementations
+// need no locking of their own. Write only receives records whose level is at
+// least GetMinLevel(); in asynchronous mode a batch holds everything the
+// writer thread drained at once, and Flush is called once after it.
+class Debug::Sink {
+public:
+    explicit Sink(const LogLevel minLevel = LogLevel::DEFAULT_DEBUG_LOG) : m_minLevel(minLevel) { }
+    virtual ~Sink() = default;
+
+    Sink(const Sink&) = delete;
+    Sink& operator=(const Sink&) = delete;
+
+    virtual void Open(const Settings&) { }
+    virtual void Close() { }
+
+    // Applies new settings with the same rootPath to an open sink. The
+    // default reopens it; sinks that can adopt them in place override this.
+    virtual void Reconfigure(const Settings& settings) { Close(); Open(settings); }
+
+    virtual void Write(const RecordBatch& records) = 0;
+    virtual void Flush() { }
+
+    // Called from the fatal signal handler installed by
+    // Debug::InstallCrashHandler, without the IO lock and possibly while
+    // another call on this sink was interrupted. Implementations may only use
+    // async-signal-safe functions: no allocation, no locks, no stdio.
+    virtual void FlushFromSignal() noexcept { }
+    virtual void WriteFromSignal(LogLevel, std::string_view) noexcept { }
+
+    NO_DISCARD LogLevel GetMinLevel() const { return m_minLevel.load(std::memory_order_relaxed); }
+    void SetMinLevel(const LogLevel level) { m_minLevel.store(level, std::memory_order_relaxed); }
+    NO_DISCARD bool Accepts(const LogLevel level) const { return level >= GetMinLevel(); }
+
+protected:
+    // Appends the record's line with "[<context>] " in front of the message,
+    // as every text sink writes it.
+    static void AppendLine(fmt::memory_buffer& buffer, const Record& record);
+
+private:
+    std::atomic<LogLevel> m_minLevel;
+};
+
+// Colored output on stdout. Warnings are yellow, errors red.
+class Debug::ConsoleSink final : public Sink {
+public:
+    explicit ConsoleSink(LogLevel minLevel = LogLevel::DEFAULT_DEBUG_LOG);
+
+    void Write(const RecordBatch& records) override;
+    void Flush() override;
+
+private:
+    fmt::memory_buffer m_buffer;
+};
+
+// Segments in <rootPath>/<directory>, named after the time they were opened
+// (to the millisecond) and a sequence number, so that every rotation creates
+// a new file. Depending on the rotation policy a segment ends before a record
+// would take it past maxFileSize, at the next local hour or day boundary, or
+// at whichever comes first. Retention (maxLogFilesAmount, deleteLogsAfter) is
+// applied to the directory whenever a new segment is opened or the settings
+// change. Each segment has a sidecar .idx file for LogIndex. Lines are
+// collected in a private buffer and written straight to the file descriptor,
+// which lets the crash handler drain them without stdio. Sinks with their own
+// file format reuse all of this through the extension, the header written at
+// the top of every segment and WriteLine.
+class Debug::FileSink final : public Sink {
+public:
+    static constexpr size_t BufferSize = 64 * 1024;
+
+    FileSink(std::filesystem::path directory, LogLevel minLevel = LogLevel::DEFAULT_DEBUG_LOG,
+             std::string extension = ".log", std::string header = {});
+    ~FileSink() override;
+
+    void Open(const Settings& settings) override;
+    void Close() override;
+    void Reconfigure(const Settings& settings) override;
+    void Write(const RecordBatch& records) override;
+    void Flush() override;
+    void FlushFromSignal() noexcept override;
+    void WriteFromSignal(LogLevel level, std::string_view text) noexcept override;
+
+    // Writes one line logged at time, rotating first if needed.
+    void WriteLine(std::chrono::system_clock::time_point time, std::string_view line);
+
+    NO_DISCARD const std::filesystem::path& GetDirectory() const;
+
+private:
+    void ApplySettings(const Settings& settings);
+    void OpenSegment();
+    void Append(const char* data, size_t size);
+    NO_DISCARD std::chrono::system_clock::rep NextDeadline(std::chrono::system_clock::time_point now) const;
+
+    std::filesystem::path m_directory;
+    std::filesystem::path m_root;
+    std::string           m_extension;
+    std::string           m_header;
+    fmt::memory_buffer    m_line;
+    std::atomic<int>      m_file;
+    std::vector<char>     m_buffer;
+    std::atomic<size_t>   m_buffered;
+    size_t                m_size;
+    size_t                m_maxFileSize;
+    uint64_t              m_sequence;
+    RotationPolicy        m_rotationPolicy;
+
+    // End of the current segment in system_clock ticks, so that the check
+    // per record is one integer compare against the record's own time.
+    std::chrono::system_clock::rep m_deadline;
+
+    int                   m_indexFile;
+    size_t                m_indexInterval;
+    size_t                m_indexedSize;
+    int64_t               m_maxTime;
+};
+
+// Keeps the most recent records in a fixed-size in-memory ring, overwriting
+// the oldest ones, so recording costs a copy and no I/O. The ring is written
+// to a new <rootPath>/<directory>/<timestamp>.flight file, named like the
+// segments, and emptied when a record at dumpLevel or above arrives, or on
+// Debug::DumpFlightRecorder(). On a fatal signal it goes to a .crash.flight
+// file instead. Retention applies to dumps apart from the .log segments, so
+// a burst of dumps cannot push error segments out.
+class Debug::FlightRecorderSink final : public Sink {
+public:
+    explicit FlightRecorderSink(size_t capacity = 16 * 1024 * 1024,
+                                LogLevel minLevel = LogLevel::DEFAULT_DEBUG_LOG,
+                                LogLevel dumpLevel = LogLevel::ERROR_DEBUG_LOG,
+                                std::filesystem::path directory = "logs/errors");
+
+    void Open(const Settings& settings) override;
+    void Write(const RecordBatch& records) override;
+    void FlushFromSignal() noexcept override;
+
+    void Dump();
+
+    NO_DISCARD size_t GetCapacity() const;
+    NO_DISCARD size_t GetRecordCount() const;
+
+private:
+    void Push(const char* data, size_t size);
+    void Copy(size_t position, char* out, size_t size) const;
+    void DropOldest();
+
+    std::vector<char>     m_ring;
+    size_t                m_head;
+    size_t                m_tail;
+    size_t                m_used;
+    size_t                m_records;
+    LogLevel              m_dumpLevel;
+    std::filesystem::path m_directory;
+    std::filesystem::path m_root;
+    std::string           m_crashDumpPath;
+    uint64_t              m_sequence;
+    fmt::memory_buffer    m_line;
+};
+
+#endif // DEBUG_LOG_SINKS_H
@@ -0,0 +1,64 @@
+#ifndef DEBUG_LOG_SOCKET_H
+#define DEBUG_LOG_SOCKET_H
+
+#include <DebugLogSinks.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+#if !defined(_WIN32)
+
+// Sends every record as one datagram to a Unix domain socket, many records
+// per sendmmsg call. While nobody is listening, or when the peer goes away,
+// records are written by a FileSink in spillDirectory instead and a
+// background thread keeps trying to reconnect. Datagrams carry the rendered
+// line, context included, without a trailing newline.
+class Debug::SocketSink final : public Sink {
+public:
+    static constexpr size_t                    MaxBatch          = 64;
+    static constexpr std::chrono::milliseconds ReconnectInterval = std::chrono::milliseconds(200);
+    static constexpr std::chrono::milliseconds SendTimeout       = std::chrono::milliseconds(100);
+
+    explicit SocketSink(std::filesystem::path socketPath,
+                        std::filesystem::path spillDirectory = "logs/spill",
+                        LogLevel minLevel = LogLevel::DEFAULT_DEBUG_LOG);
+    ~SocketSink() override;
+
+    void Open(const Settings& settings) override;
+    void Close() override;
+    void Reconfigure(const Settings& settings) override;
+    void Write(const RecordBatch& records) override;
+    void Flush() override;
+    void FlushFromSignal() noexcept override;
+    void WriteFromSignal(LogLevel level, std::string_view text) noexcept override;
+
+    NO_DISCARD bool IsConnected() const;
+    NO_DISCARD const std::filesystem::path& GetSocketPath() const;
+
+private:
+    bool Connect();
+    void Disconnect();
+    void Spill(const RecordBatch& records);
+    void ReconnectLoop();
+    void StopReconnecting();
+
+    std::filesystem::path   m_socketPath;
+    FileSink                m_spill;
+    Settings                m_settings;
+    bool                    m_spillOpen;
+    std::atomic<int>        m_socket;
+    // Lines of the records in a sendmmsg batch that have a context.
+    fmt::memory_buffer      m_lines;
+
+    std::mutex              m_reconnectMutex;
+    std::condition_variable m_reconnectCondition;
+    std::thread             m_reconnectThread;
+    bool                    m_stopping;
+};
+
+#endif // !_WIN32
+
+#endif // DEBUG_LOG_SOCKET_H
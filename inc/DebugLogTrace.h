@@ -0,0 +1,35 @@
+#ifndef DEBUG_LOG_TRACE_H
+#define DEBUG_LOG_TRACE_H
+
+#include <DebugLogSinks.h>
+#include <filesystem>
+
+// Writes records as Chrome trace events, which chrome://tracing and the
+// Perfetto UI open directly. Every span becomes one complete event with its
+// duration on the thread that measured it, and every other record an instant
+// event on its thread. Context fields go under "context" in the args. Segments are <timestamp>.json files in <rootPath>/<directory>,
+// rotated and retained like the .log segments. Each one starts a JSON array
+// and has one event per line, each followed by a comma; the trace event
+// format allows the closing bracket to be missing, so a segment stays
+// readable however it ends.
+class Debug::TraceSink final : public Sink {
+public:
+    explicit TraceSink(std::filesystem::path directory = "logs/trace", LogLevel minLevel = LogLevel::DEFAULT_DEBUG_LOG);
+
+    void Open(const Settings& settings) override;
+    void Close() override;
+    void Reconfigure(const Settings& settings) override;
+    void Write(const RecordBatch& records) override;
+    void Flush() override;
+    void FlushFromSignal() noexcept override;
+
+    NO_DISCARD const std::filesystem::path& GetDirectory() const;
+
+private:
+    void WriteEvent(const Record& record, char phase, std::chrono::system_clock::time_point time);
+
+    FileSink           m_file;
+    fmt::memory_buffer m_event;
+};
+
+#endif // DEBUG_LOG_TRACE_H
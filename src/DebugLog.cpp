@@ -1,125 +1,759 @@
 #include <DebugLog.h>
+#include <DebugLogArena.h>
+#include <DebugLogIndex.h>
+#include <DebugLogSinks.h>
 #include <filesystem>
-#include <ostream>
-#include <fstream>
 #include <iomanip>
 #include <sstream>
 #include <ctime>
 #include <queue>
+#include <tuple>
+#include <cstring>
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <utility>
 
-#include "fmt/os.h"
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
 
 #ifndef DISABLE_LOGGING_STACKTRACE
 #include <boost/stacktrace.hpp>
 #endif
 
-#include <fmt/color.h>
-#include <fmt/ostream.h>
 #include <utf8.h>
 
-inline std::string sanitizeUtf8(const std::string& str) {
-    if (utf8::is_valid(str)) return str;
-    return utf8::replace_invalid(str, U'\uFFFD');
+inline std::string_view sanitizeUtf8(const std::string_view str) {
+    if (utf8::is_valid(str.begin(), str.end())) return str;
+
+    thread_local std::string replaced;
+    replaced.clear();
+    utf8::replace_invalid(str.begin(), str.end(), std::back_inserter(replaced), U'\uFFFD');
+    return replaced;
 }
 
 std::mutex Debug::m_mutex{};
-std::ofstream Debug::m_fileLogStream{};
-std::ofstream Debug::m_fileLogErrorStream{};
 bool Debug::m_initFlag{};
-Debug::Settings Debug::m_settings{
-    "",
-    2 * 1024 * 1024,
-    10,
-    60 * 60 * 24 * 7
-};
-size_t Debug::m_currentLogStreamFileSize{};
-size_t Debug::m_currentLogErrorStreamFileSize{};
-
-const char* Debug::LogTypeToString(const DebugLogType_ type) {
+std::shared_ptr<const Debug::Settings> Debug::m_settings = std::make_shared<const Debug::Settings>();
+std::vector<std::shared_ptr<Debug::Sink>> Debug::m_sinks = CreateDefaultSinks();
+std::atomic<const std::vector<Debug::Sink*>*> Debug::m_signalSinks{};
+
+Debug::RecordArena Debug::m_arena{Settings{}.asyncMemoryLimit};
+std::atomic<const Debug::Record*> Debug::m_queueHead{};
+std::atomic<bool> Debug::m_asyncFlag{};
+std::mutex Debug::m_queueMutex{};
+std::condition_variable Debug::m_queueCondition{};
+std::thread Debug::m_writerThread{};
+size_t Debug::m_writerGeneration{};
+uint64_t Debug::m_flushRequested{};
+uint64_t Debug::m_flushCompleted{};
+std::condition_variable Debug::m_flushCondition{};
+std::vector<Debug::FlushWaiter_> Debug::m_flushWaiters{};
+std::atomic<Debug::LogLevel> Debug::m_minLevel{LogLevel::DEFAULT_DEBUG_LOG};
+
+// Stops the writer thread before the statics above are destroyed. Defined
+// after them so that it is destroyed first.
+static struct ShutdownAtExit_ {
+    ~ShutdownAtExit_() {
+        Debug::Shutdown();
+    }
+} shutdownAtExit_;
+
+fmt::memory_buffer& Debug::GetMessageBuffer() {
+    thread_local fmt::memory_buffer buffer;
+    return buffer;
+}
+
+const char* Debug::LogTypeToString(const LogLevel type) {
     switch (type) {
-        case DebugLogType_::DEFAULT_DEBUG_LOG: return "LOG";
-        case DebugLogType_::WARNING_DEBUG_LOG: return "WARNING";
-        case DebugLogType_::ERROR_DEBUG_LOG:   return "ERROR";
+        case LogLevel::DEFAULT_DEBUG_LOG: return "LOG";
+        case LogLevel::WARNING_DEBUG_LOG: return "WARNING";
+        case LogLevel::ERROR_DEBUG_LOG:   return "ERROR";
     }
     return "UNKNOWN";
 }
 
-void Debug::LogI(const std::string& message, const DebugLogType_ type) {
+std::vector<std::shared_ptr<Debug::Sink>> Debug::CreateDefaultSinks() {
+    std::vector<std::shared_ptr<Sink>> sinks;
+#ifndef DISABLE_CONSOLE_LOGGING
+    sinks.push_back(std::make_shared<ConsoleSink>());
+#endif // !DISABLE_CONSOLE_LOGGING
+#ifndef DISABLE_FILE_LOGGING
+    sinks.push_back(std::make_shared<FileSink>("logs/all", LogLevel::DEFAULT_DEBUG_LOG));
+    sinks.push_back(std::make_shared<FileSink>("logs/errors", LogLevel::WARNING_DEBUG_LOG));
+#endif // !DISABLE_FILE_LOGGING
+    return sinks;
+}
+
+void Debug::AddSink(const std::shared_ptr<Sink>& sink) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DrainQueueLocked();
+
+    if (m_initFlag) {
+        sink->Open(*m_settings);
+    }
+    m_sinks.push_back(sink);
+    PublishSinksLocked();
+}
+
+void Debug::RemoveSink(const std::shared_ptr<Sink>& sink) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DrainQueueLocked();
+
+    const auto it = std::find(m_sinks.begin(), m_sinks.end(), sink);
+    if (it == m_sinks.end()) {
+        return;
+    }
+
+    m_sinks.erase(it);
+    PublishSinksLocked();
+    if (m_initFlag) {
+        sink->Close();
+    }
+}
+
+std::vector<std::shared_ptr<Debug::Sink>> Debug::GetSinks() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_sinks;
+}
+
+void Debug::DumpFlightRecorder() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DrainQueueLocked();
+
+    for (const std::shared_ptr<Sink>& sink : m_sinks) {
+        if (auto* recorder = dynamic_cast<FlightRecorderSink*>(sink.get())) {
+            recorder->Dump();
+        }
+    }
+}
+
+void Debug::LogI(const std::string_view message, const LogLevel type, const SourceLocation& location, const LogSite* site) {
 #ifndef DISABLE_LOGGING
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
+    if (!IsEnabled(type)) {
+        return;
+    }
+    Submit(CreateRecord(message, type, location, site));
+#endif // !DISABLE_LOGGING
+}
 
-        if (!m_initFlag) {
-            m_initFlag = true;
-            Init();
+void Debug::SubmitPacked(const LogSite& site, const std::string_view arguments, const Renderer renderer) {
+#ifndef DISABLE_LOGGING
+    Submit(AllocateRecord(site.level, std::chrono::system_clock::now(), arguments, 0, 0, GetThreadId(), {}, {},
+                          renderer, &site, site.location, GetCurrentContext()));
+#endif // !DISABLE_LOGGING
+}
+
+void Debug::Forward(const LogLevel type, const std::chrono::system_clock::time_point time, const std::string_view text) {
+#ifndef DISABLE_LOGGING
+    if (!IsEnabled(type)) {
+        return;
+    }
+    const std::string_view sanitizedText = sanitizeUtf8(text);
+
+    // The message is whatever follows the "[LEVEL   timestamp] " prefix, up
+    // to the stacktrace if there is one.
+    const size_t prefixEnd = sanitizedText.find("] ");
+    const size_t messageOffset = prefixEnd == std::string_view::npos ? 0 : prefixEnd + 2;
+    const size_t messageEnd = std::min(sanitizedText.find("\nStacktrace ( \n", messageOffset), sanitizedText.size());
+
+    Submit(AllocateRecord(type, time, sanitizedText, messageOffset, messageEnd - messageOffset));
+#endif // !DISABLE_LOGGING
+}
+
+void Debug::Submit(RecordPtr record) {
+    InstallAlternateStack();
+
+    // Deferred records are counted once rendered.
+    if (!record->m_renderer) {
+        CountRecord(record->level, record->text.size());
+    }
+
+    if (record->m_pooled && m_asyncFlag.load(std::memory_order_acquire)) {
+        Enqueue(std::move(record));
+        return;
+    }
+
+    // Synchronous mode, or the arena is exhausted: write in place, after
+    // anything still queued so that the output order is preserved. Only a
+    // contended lock is timed.
+    std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        const auto waitStart = std::chrono::steady_clock::now();
+        lock.lock();
+        CountLockWait(std::chrono::steady_clock::now() - waitStart);
+    }
+    DrainQueueLocked();
+
+    if (!m_initFlag) {
+        m_initFlag = true;
+        Init();
+    }
+
+    if (m_settings->asynchronous) {
+        StartWriter();
+    }
+
+    // As on the writer thread, an event that fails to render is dropped
+    // rather than thrown into the caller.
+    if (record->m_renderer) {
+        try {
+            record = RenderDeferred(*record);
+        } catch (const fmt::format_error&) {
+            CountDropped(1);
+            return;
         }
+    }
+
+    const Record* records[] = {record.get()};
+    DispatchLocked(records, 1);
+}
+
+Debug::RecordPtr Debug::CreateRecord(const std::string_view message, const LogLevel type, const SourceLocation& location,
+                                     const LogSite* site) {
+    const auto now = std::chrono::system_clock::now();
+    const uint64_t thread = GetThreadId();
 
-        const std::string timeStamp = GetTimestamp();
+    const Layout& layout = GetLayout();
+    thread_local fmt::memory_buffer line;
+    line.clear();
+    FormatPrefix(layout, line, type, now, thread, location);
+    const size_t messageOffset = line.size();
+
+    const std::string_view sanitizedMessage = sanitizeUtf8(message);
+    line.append(sanitizedMessage.data(), sanitizedMessage.data() + sanitizedMessage.size());
+    FormatSuffix(layout, line, type, now, thread, location);
 
 #ifndef DISABLE_LOGGING_STACKTRACE
-        std::string formatted;
-        if (type != DebugLogType_::DEFAULT_DEBUG_LOG) {
-            const boost::stacktrace::stacktrace stacktrace(4, -1);
-            formatted = fmt::format("[{:<8}{}] {}\nStacktrace ( \n{})", LogTypeToString(type), timeStamp, message,  boost::stacktrace::to_string(stacktrace));
-        } else {
-            formatted = fmt::format("[{:<8}{}] {}", LogTypeToString(type), timeStamp, message);
-        }
+    if (type != LogLevel::DEFAULT_DEBUG_LOG) {
+        const auto captureStart = std::chrono::steady_clock::now();
+        const boost::stacktrace::stacktrace stacktrace(5, -1);
+        fmt::format_to(fmt::appender(line), "\nStacktrace ( \n{})", sanitizeUtf8(boost::stacktrace::to_string(stacktrace)));
+        CountStacktrace(std::chrono::steady_clock::now() - captureStart);
+    }
+#endif
+
+    return AllocateRecord(type, now, std::string_view(line.data(), line.size()), messageOffset, sanitizedMessage.size(),
+                          thread, {}, {}, nullptr, site, location, GetCurrentContext());
+}
+
+Debug::RecordPtr Debug::AllocateRecord(const LogLevel type, const std::chrono::system_clock::time_point time,
+                                       const std::string_view text, const size_t messageOffset, const size_t messageSize,
+                                       const uint64_t thread, const std::string_view spanName,
+                                       const std::chrono::nanoseconds spanDuration, const Renderer renderer,
+                                       const LogSite* site, const SourceLocation& location,
+                                       std::shared_ptr<const Context> context) {
+    // Records normally come from the arena. When it is exhausted the record
+    // is allocated on its own and written synchronously by the caller.
+    const size_t size = sizeof(Record) + text.size() + spanName.size();
+    bool pooled = true;
+    void* memory = m_arena.Allocate(size);
+    if (!memory) {
+        pooled = false;
+        memory = std::malloc(size);
+        if (!memory) throw std::bad_alloc();
+    }
+
+    char* copy = static_cast<char*>(memory) + sizeof(Record);
+    if (!text.empty()) {
+        std::memcpy(copy, text.data(), text.size());
+    }
+    char* spanNameCopy = copy + text.size();
+    if (!spanName.empty()) {
+        std::memcpy(spanNameCopy, spanName.data(), spanName.size());
+    }
+
+    const Record* record = new (memory) Record(
+        type,
+        time,
+        std::string_view(copy + messageOffset, messageSize),
+        std::string_view(copy, text.size()),
+        thread,
+        std::string_view(spanNameCopy, spanName.size()),
+        spanDuration,
+        site,
+        location,
+        std::move(context),
+        renderer,
+        pooled
+    );
+    return RecordPtr(record, RecordPtr::Adopt_{});
+}
+
+Debug::RecordPtr Debug::RenderDeferred(const Record& record) {
+    const Layout& layout = GetLayout();
+    thread_local fmt::memory_buffer line;
+    line.clear();
+    FormatPrefix(layout, line, record.level, record.time, record.thread, record.location);
+    const size_t messageOffset = line.size();
+    record.m_renderer(record, line);
+
+    // String arguments of a call site are only checked now.
+    const std::string_view rendered(line.data() + messageOffset, line.size() - messageOffset);
+    const std::string_view message = sanitizeUtf8(rendered);
+    if (message.data() != rendered.data()) {
+        line.resize(messageOffset);
+        line.append(message.data(), message.data() + message.size());
+    }
+    const size_t messageSize = line.size() - messageOffset;
+    FormatSuffix(layout, line, record.level, record.time, record.thread, record.location);
+
+    const std::string_view text(line.data(), line.size());
+    CountRecord(record.level, text.size());
+    return AllocateRecord(record.level, record.time, text, messageOffset, messageSize,
+                          record.thread, record.spanName, record.spanDuration, nullptr, record.site, record.location, record.context);
+}
+
+void Debug::EndSpan(const std::string_view name, const LogLevel level, const std::chrono::steady_clock::duration duration) {
+#ifndef DISABLE_LOGGING
+    if (!IsEnabled(level)) {
+        return;
+    }
+
+    static constexpr Renderer renderSpan = [](const Record& record, fmt::memory_buffer& message) {
+        fmt::format_to(fmt::appender(message), "{} took {:.3f} us (thread {})", record.spanName,
+                       std::chrono::duration<double, std::micro>(record.spanDuration).count(), record.thread);
+    };
+
+    Submit(AllocateRecord(level, std::chrono::system_clock::now(), {}, 0, 0, GetThreadId(), name.empty() ? "span" : name,
+                          std::chrono::duration_cast<std::chrono::nanoseconds>(duration), renderSpan, nullptr, {},
+                          GetCurrentContext()));
+#endif // !DISABLE_LOGGING
+}
+
+uint64_t Debug::GetThreadId() {
+    thread_local const uint64_t id = [] {
+#if defined(_WIN32)
+        return static_cast<uint64_t>(GetCurrentThreadId());
+#elif defined(__linux__)
+        return static_cast<uint64_t>(syscall(SYS_gettid));
+#elif defined(__APPLE__)
+        uint64_t thread = 0;
+        pthread_threadid_np(nullptr, &thread);
+        return thread;
 #else
-        const std::string formatted = fmt::format("[{:<8}{}] {}", LogTypeToString(type), timeStamp, message);
+        return static_cast<uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
 #endif
-        switch (type) {
-        case DebugLogType_::DEFAULT_DEBUG_LOG:
-#ifndef DISABLE_CONSOLE_LOGGING
-            fmt::print("{}\n", sanitizeUtf8(formatted));
-#endif // !DISABLE_CONSOLE_LOGGING
-#ifndef DISABLE_FILE_LOGGING
-            m_currentLogStreamFileSize += formatted.size() + 1;
-            m_fileLogStream << formatted << std::endl;
-#endif // !DISABLE_FILE_LOGGING
-            break;
+    }();
+    return id;
+}
 
-        case DebugLogType_::WARNING_DEBUG_LOG:
-#ifndef DISABLE_CONSOLE_LOGGING
-            fmt::print(fg(fmt::color::yellow), "{}\n", sanitizeUtf8(formatted));
-#endif // !DISABLE_CONSOLE_LOGGING
-#ifndef DISABLE_FILE_LOGGING
-            m_currentLogStreamFileSize += formatted.size() + 1;
-            m_currentLogErrorStreamFileSize += formatted.size() + 1;
-            m_fileLogStream << formatted << std::endl;
-            m_fileLogErrorStream << formatted << std::endl;
-#endif // !DISABLE_FILE_LOGGING
-            break;
+namespace {
+    // Resumes FlushAsync coroutines on a thread of its own, so that the
+    // writer never runs user code and can always be joined, even after a
+    // coroutine shut the logger down. Started on first use and joined at exit.
+    class FlushResumer_ {
+    public:
+        using Waiter = std::pair<void (*)(void*), void*>;
+
+        ~FlushResumer_() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_condition.notify_all();
 
-        case DebugLogType_::ERROR_DEBUG_LOG:
-#ifndef DISABLE_CONSOLE_LOGGING
-            fmt::print(fg(fmt::color::red), "{}\n", sanitizeUtf8(formatted));
-#endif // !DISABLE_CONSOLE_LOGGING
-#ifndef DISABLE_FILE_LOGGING
-            m_currentLogStreamFileSize += formatted.size() + 1;
-            m_currentLogErrorStreamFileSize += formatted.size() + 1;
-            m_fileLogStream << formatted << std::endl;
-            m_fileLogErrorStream << formatted << std::endl;
-#endif // !DISABLE_FILE_LOGGING
-            break;
+            if (!m_thread.joinable()) {
+                return;
+            }
+            if (m_thread.get_id() == std::this_thread::get_id()) {
+                m_thread.detach();
+            } else {
+                m_thread.join();
+            }
         }
 
-#ifndef DISABLE_FILE_LOGGING
-        if (m_currentLogStreamFileSize < m_settings.maxFileSize && m_currentLogErrorStreamFileSize < m_settings.maxFileSize) {
+        void Post(const std::vector<Waiter>& waiters) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_waiters.insert(m_waiters.end(), waiters.begin(), waiters.end());
+                if (!m_thread.joinable()) {
+                    m_thread = std::thread(&FlushResumer_::Run, this);
+                }
+            }
+            m_condition.notify_one();
+        }
+
+    private:
+        void Run() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (true) {
+                m_condition.wait(lock, [this] { return m_stopping || !m_waiters.empty(); });
+                if (m_waiters.empty()) {
+                    return;
+                }
+
+                std::vector<Waiter> waiters;
+                waiters.swap(m_waiters);
+                lock.unlock();
+                for (const Waiter& waiter : waiters) {
+                    waiter.first(waiter.second);
+                }
+                lock.lock();
+            }
+        }
+
+        std::mutex              m_mutex;
+        std::condition_variable m_condition;
+        std::vector<Waiter>     m_waiters;
+        std::thread             m_thread;
+        bool                    m_stopping = false;
+    };
+
+    FlushResumer_& GetFlushResumer() {
+        static FlushResumer_ resumer;
+        return resumer;
+    }
+
+    // Sites by id - 1. Function-local so that sites in static initializers
+    // of other translation units can register.
+    struct SiteRegistry_ {
+        std::mutex                           mutex;
+        std::vector<const Debug::LogSite*>   sites;
+    };
+
+    SiteRegistry_& GetSiteRegistry() {
+        static SiteRegistry_ registry;
+        return registry;
+    }
+
+    uint32_t RegisterSite(const Debug::LogSite* site) {
+        SiteRegistry_& registry = GetSiteRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.sites.push_back(site);
+        return static_cast<uint32_t>(registry.sites.size());
+    }
+
+    // True if a replacement field has the 'p' presentation type, e.g. "{:p}"
+    // or "{0:>18p}".
+    bool FormatsPointers(const std::string_view format) {
+        for (size_t i = 0; i < format.size(); ++i) {
+            if (format[i] != '{') {
+                continue;
+            }
+            if (i + 1 < format.size() && format[i + 1] == '{') {
+                ++i;
+                continue;
+            }
+
+            // Dynamic width and precision nest braces inside the spec.
+            size_t end = i + 1;
+            for (int depth = 1; end < format.size(); ++end) {
+                if (format[end] == '{') {
+                    ++depth;
+                } else if (format[end] == '}' && --depth == 0) {
+                    break;
+                }
+            }
+            if (end == format.size()) {
+                return false;
+            }
+
+            const std::string_view field = format.substr(i + 1, end - i - 1);
+            if (field.find(':') != std::string_view::npos && field.back() == 'p') {
+                return true;
+            }
+            i = end;
+        }
+        return false;
+    }
+}
+
+Debug::LogSite::LogSite(const LogLevel level, const std::string_view format, const SourceLocation& location)
+    : id(RegisterSite(this)), level(level), format(format), location(location),
+      formatsPointers(FormatsPointers(format)) { }
+
+const Debug::LogSite* Debug::LogSite::Find(const uint32_t id) {
+    SiteRegistry_& registry = GetSiteRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return id > 0 && id <= registry.sites.size() ? registry.sites[id - 1] : nullptr;
+}
+
+void Debug::DestroyRecord(const Record* record) {
+    const bool pooled = record->m_pooled;
+    void* memory = const_cast<Record*>(record);
+    record->~Record();
+
+    if (pooled) {
+        RecordArena::Release(memory);
+    } else {
+        std::free(memory);
+    }
+}
+
+void Debug::Enqueue(RecordPtr record) {
+    const Record* queued = record.Detach();
+
+    const Record* head = m_queueHead.load(std::memory_order_relaxed);
+    do {
+        queued->m_next = head;
+    } while (!m_queueHead.compare_exchange_weak(head, queued, std::memory_order_release, std::memory_order_relaxed));
+
+    // Only the push onto an empty queue has to wake the writer; otherwise it
+    // is either awake already or about to see the non-empty queue.
+    if (!head) {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_queueCondition.notify_one();
+    }
+}
+
+void Debug::DispatchLocked(const Record* const* records, const size_t count) {
+    thread_local std::vector<const Record*> accepted;
+
+    for (const std::shared_ptr<Sink>& sink : m_sinks) {
+        accepted.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (sink->Accepts(records[i]->level)) {
+                accepted.push_back(records[i]);
+            }
+        }
+
+        if (accepted.empty()) {
+            continue;
+        }
+
+        sink->Write(RecordBatch(accepted.data(), accepted.size()));
+
+        // Warnings and errors are always flushed right away; plain lines may
+        // wait in the sink's buffer when the crash handler guards them.
+        const bool important = std::any_of(accepted.begin(), accepted.end(), [](const Record* record) {
+            return record->level != LogLevel::DEFAULT_DEBUG_LOG;
+        });
+        if (m_settings->flushOnEveryWrite || important) {
+            sink->Flush();
+            CountFlush();
+        }
+    }
+
+    if (m_settings->statsInterval > 0) {
+        LogStatsLocked();
+    }
+}
+
+void Debug::DrainQueueLocked() {
+    const Record* queued = m_queueHead.exchange(nullptr, std::memory_order_acquire);
+    if (!queued) {
+        return;
+    }
+
+    // The queue is a LIFO stack; reverse it to restore the logging order.
+    thread_local std::vector<const Record*> batch;
+    batch.clear();
+    for (; queued; queued = queued->m_next) {
+        batch.push_back(queued);
+    }
+    std::reverse(batch.begin(), batch.end());
+    CountQueueDepth(batch.size());
+
+    // The queue owned one reference to each record; drop it even if a sink
+    // throws.
+    struct ReleaseBatch_ {
+        ~ReleaseBatch_() {
+            for (const Record* record : batch) {
+                record->Release();
+            }
+        }
+    } release;
+
+    // Compact events are rendered here, off the logging threads. One that
+    // fails to render, e.g. on an argument its format rejects, is dropped
+    // without taking the rest of the batch with it.
+    size_t rendered = 0;
+    for (const Record* record : batch) {
+        if (record->m_renderer) {
+            try {
+                RecordPtr line = RenderDeferred(*record);
+                record->Release();
+                record = line.Detach();
+            } catch (...) {
+                record->Release();
+                CountDropped(1);
+                continue;
+            }
+        }
+        batch[rendered++] = record;
+    }
+    batch.resize(rendered);
+
+    try {
+        if (!m_initFlag) {
+            m_initFlag = true;
+            Init();
+        }
+
+        DispatchLocked(batch.data(), batch.size());
+    } catch (...) {
+        CountDropped(batch.size());
+        throw;
+    }
+}
+
+void Debug::CloseLocked() {
+    for (const std::shared_ptr<Sink>& sink : m_sinks) {
+        sink->Close();
+    }
+    m_initFlag = false;
+}
+
+void Debug::StartWriter() {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    if (m_writerThread.joinable()) {
+        return;
+    }
+
+    m_writerThread = std::thread(WriterLoop, m_writerGeneration);
+    m_asyncFlag.store(true, std::memory_order_release);
+}
+
+void Debug::StopWriter() {
+    std::thread writer;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_asyncFlag.store(false, std::memory_order_release);
+        if (!m_writerThread.joinable()) {
             return;
         }
-#endif // !DISABLE_FILE_LOGGING
+
+        writer = std::move(m_writerThread);
+        ++m_writerGeneration;
     }
 
-#ifndef DISABLE_FILE_LOGGING
-    Shutdown();
-#endif // !DISABLE_FILE_LOGGING
+    m_queueCondition.notify_all();
+    writer.join();
+}
 
-#endif // !DISABLE_LOGGING
+void Debug::WriterLoop(const size_t generation) {
+    bool stopping = false;
+    while (!stopping) {
+        uint64_t flushTicket = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCondition.wait(lock, [generation] {
+                return m_writerGeneration != generation || m_queueHead.load(std::memory_order_acquire) != nullptr
+                       || m_flushRequested != m_flushCompleted;
+            });
+            stopping = m_writerGeneration != generation;
+            flushTicket = m_flushRequested;
+        }
+
+        WriteQueued(flushTicket);
+    }
+}
+
+void Debug::WriteQueued(const uint64_t flushTicket) {
+    InstallAlternateStack();
+
+    // Everything logged before the ticket was taken is in the queue by now,
+    // so this batch completes it.
+    bool flush = false;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        flush = flushTicket > m_flushCompleted;
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        DrainQueueLocked();
+        if (flush) {
+            FlushSinksLocked();
+        }
+    } catch (...) {
+        // There is nobody to report to on the writer thread; the records
+        // have been released and the next batch retries opening the files.
+    }
+
+    if (!flush) {
+        return;
+    }
+
+    std::vector<FlushResumer_::Waiter> resumable;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_flushCompleted = std::max(m_flushCompleted, flushTicket);
+        const auto done = std::partition(m_flushWaiters.begin(), m_flushWaiters.end(),
+                                         [flushTicket](const FlushWaiter_& waiter) { return waiter.ticket > flushTicket; });
+        for (auto waiter = done; waiter != m_flushWaiters.end(); ++waiter) {
+            resumable.emplace_back(waiter->resume, waiter->address);
+        }
+        m_flushWaiters.erase(done, m_flushWaiters.end());
+    }
+    m_flushCondition.notify_all();
+
+    if (!resumable.empty()) {
+        GetFlushResumer().Post(resumable);
+    }
+}
+
+void Debug::Flush() {
+    const uint64_t ticket = RequestFlush();
+    if (ticket == 0) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    m_flushCondition.wait(lock, [ticket] { return m_flushCompleted >= ticket; });
+}
+
+uint64_t Debug::RequestFlush() {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (m_writerThread.joinable()) {
+            m_queueCondition.notify_one();
+            return ++m_flushRequested;
+        }
+    }
+
+    // Without a writer records are written in place; only what was queued
+    // before it stopped and the sinks' buffers are left.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    DrainQueueLocked();
+    FlushSinksLocked();
+    return 0;
+}
+
+bool Debug::AwaitFlush(const uint64_t ticket, void (*resume)(void*), void* address) {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    if (m_flushCompleted >= ticket) {
+        return false;
+    }
+
+    m_flushWaiters.push_back({ticket, resume, address});
+    return true;
+}
+
+void Debug::FlushSinksLocked() {
+    for (const std::shared_ptr<Sink>& sink : m_sinks) {
+        sink->Flush();
+        CountFlush();
+    }
 }
 
 std::string Debug::GetTimestamp() {
-    const auto now = std::chrono::system_clock::now();
+    return std::string(GetCachedTimestamp(std::chrono::system_clock::now()));
+}
+
+std::string_view Debug::GetCachedTimestamp(const std::chrono::system_clock::time_point now) {
+    // The timestamp only changes once per second, so each thread keeps the
+    // last rendered value and skips localtime/strftime until it goes stale.
+    thread_local std::time_t cachedTime = -1;
+    thread_local char cached[32]{};
+    thread_local size_t cachedLength = 0;
+
     const std::time_t nowTime = std::chrono::system_clock::to_time_t(now);
+    if (nowTime == cachedTime) {
+        return {cached, cachedLength};
+    }
+
     std::tm localTime{};
     
 #if defined(_WIN32)
@@ -128,9 +762,42 @@ std::string Debug::GetTimestamp() {
         localtime_r(&nowTime, &localTime);
 #endif
 
-    std::ostringstream oss;
-    oss << std::put_time(&localTime, "%Y-%m-%d_%H-%M-%S");
-    return oss.str();
+    cachedLength = std::strftime(cached, sizeof(cached), "%Y-%m-%d_%H-%M-%S", &localTime);
+    cachedTime = nowTime;
+    return {cached, cachedLength};
+}
+
+std::string Debug::GetSegmentName(const std::chrono::system_clock::time_point now, const uint64_t sequence) {
+    const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+    return fmt::format("{}.{:03}_{:06}.log", GetCachedTimestamp(now), milliseconds, sequence);
+}
+
+void Debug::ParseSegmentName(const std::string_view fileName, std::chrono::system_clock::time_point& time, uint64_t& sequence) {
+    // <timestamp>[.<milliseconds>_<sequence>][.<suffix>].log; names without
+    // the sub-second part come from older versions or other tools.
+    constexpr size_t timestampLength = 19;
+    time = ParseTimestamp(std::string(fileName.substr(0, timestampLength)));
+    sequence = 0;
+
+    size_t position = timestampLength;
+    auto parseNumber = [&](const size_t maxDigits) {
+        uint64_t value = 0;
+        const size_t start = position;
+        while (position < fileName.size() && position - start < maxDigits
+               && fileName[position] >= '0' && fileName[position] <= '9') {
+            value = value * 10 + static_cast<uint64_t>(fileName[position++] - '0');
+        }
+        return value;
+    };
+
+    if (position < fileName.size() && fileName[position] == '.') {
+        ++position;
+        time += std::chrono::milliseconds(parseNumber(3));
+    }
+    if (position < fileName.size() && fileName[position] == '_') {
+        ++position;
+        sequence = parseNumber(20);
+    }
 }
 
 std::chrono::time_point<std::chrono::system_clock> Debug::ParseTimestamp(const std::string_view str) {
@@ -146,82 +813,94 @@ std::chrono::time_point<std::chrono::system_clock> Debug::ParseTimestamp(const s
 }
 
 void Debug::SetSettings(const Settings& settings) {
+    // Compiled first, so that an invalid pattern changes nothing.
+    const Layout* layout = CompileLayout(settings);
+    std::shared_ptr<const Settings> snapshot = std::make_shared<const Settings>(settings);
+
+    // The writer keeps running unless logging becomes synchronous; it would
+    // only wait for the IO lock below like any other thread.
+    if (!snapshot->asynchronous) {
+        StopWriter();
+    }
+
     std::lock_guard<std::mutex> lock(m_mutex);
+    DrainQueueLocked();
+
+    const bool reopen = !m_initFlag || snapshot->rootPath != m_settings->rootPath;
+    std::atomic_store_explicit(&m_settings, snapshot, std::memory_order_release);
+    m_layout.store(layout, std::memory_order_release);
+    m_minLevel.store(snapshot->minLevel, std::memory_order_relaxed);
+    m_arena.SetMemoryLimit(snapshot->asyncMemoryLimit);
+    m_statsDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(snapshot->statsInterval);
+
+    if (reopen) {
+        CloseLocked();
+        m_initFlag = true;
+        Init();
+    } else {
+        for (const std::shared_ptr<Sink>& sink : m_sinks) {
+            sink->Reconfigure(*snapshot);
+        }
+    }
 
-    m_settings = settings;
-    if (m_fileLogStream.is_open() || m_fileLogErrorStream.is_open()) {
-        Shutdown();
+    if (snapshot->asynchronous) {
+        StartWriter();
     }
+}
 
-    m_initFlag = true;
-    Init();
+std::shared_ptr<const Debug::Settings> Debug::GetSettings() {
+    return std::atomic_load_explicit(&m_settings, std::memory_order_acquire);
 }
 
 void Debug::Shutdown() {
+    StopWriter();
+
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_fileLogStream.is_open()) m_fileLogStream.close();
-    if (m_fileLogErrorStream.is_open()) m_fileLogErrorStream.close();
-    m_initFlag = false;
+    DrainQueueLocked();
+    CloseLocked();
 }
 
 
 void Debug::Init() {
-    if (!std::filesystem::is_directory(std::filesystem::path("logs/"))) {
-        std::filesystem::create_directory(std::filesystem::path("logs/"));
-    }
-
-    const std::filesystem::path allLogsRoot = std::filesystem::path(m_settings.rootPath / "logs/all/");
-    const std::filesystem::path errorLogsRoot = std::filesystem::path(m_settings.rootPath / "logs/errors/");
-
-    std::filesystem::create_directories(allLogsRoot);
-    std::filesystem::create_directories(errorLogsRoot);
-
-    const std::string fileName = GetTimestamp() + ".log";
-    const std::filesystem::path allLogPath(allLogsRoot / fileName);
-    const std::filesystem::path errorLogPath(errorLogsRoot / fileName);
-
-    m_fileLogStream.open(allLogPath, std::ios::out | std::ios::app);
-    m_fileLogErrorStream.open(errorLogPath, std::ios::out | std::ios::app);
-
-    ClearLogs(allLogsRoot);
-    ClearLogs(errorLogsRoot);
-
-    if (!m_fileLogStream.is_open() || !m_fileLogErrorStream.is_open()) {
-        throw std::runtime_error("Failed to open log files.");
+    for (const std::shared_ptr<Sink>& sink : m_sinks) {
+        sink->Open(*m_settings);
     }
 }
 
-void Debug::ClearLogs(const std::filesystem::path& rootPath) {
-    std::priority_queue<
-        std::pair<std::chrono::time_point<std::chrono::system_clock>, std::string>,
-        std::vector<std::pair<std::chrono::system_clock::time_point, std::string>>,
-        std::greater<>
-    > logFilesNames;
+void Debug::ClearLogs(const std::filesystem::path& rootPath, const std::string_view extension) {
+    using SegmentKey = std::tuple<std::chrono::system_clock::time_point, uint64_t, std::string>;
+    std::priority_queue<SegmentKey, std::vector<SegmentKey>, std::greater<>> logFilesNames;
     const std::chrono::time_point<std::chrono::system_clock> now = std::chrono::system_clock::now();
+    std::error_code error; // a segment may have no index
 
     for (const auto& file : std::filesystem::directory_iterator(rootPath)) {
         if (!file.is_regular_file())
             continue;
 
-        if (file.path().extension() != ".log")
+        if (file.path().extension() != extension)
             continue;
 
         try {
             std::string fileName = file.path().filename().string();
-            std::chrono::time_point<std::chrono::system_clock> timestamp = ParseTimestamp(fileName.substr(0, fileName.size()-4));
+            std::chrono::time_point<std::chrono::system_clock> timestamp;
+            uint64_t sequence = 0;
+            ParseSegmentName(fileName, timestamp, sequence);
 
             auto diff = std::chrono::duration_cast<std::chrono::seconds>(now - timestamp);
-            if (diff.count() > m_settings.deleteLogsAfter) {
+            if (diff.count() > static_cast<long long>(m_settings->deleteLogsAfter)) {
                 std::filesystem::remove(file);
+                std::filesystem::remove(LogIndex::GetIndexPath(file.path()), error);
                 continue;
             }
 
-            logFilesNames.emplace(timestamp, fileName);
+            logFilesNames.emplace(timestamp, sequence, fileName);
         }  catch (...) { }
     }
 
-    while (logFilesNames.size() > m_settings.maxLogFilesAmount) {
-        std::filesystem::remove(rootPath / logFilesNames.top().second);
+    while (logFilesNames.size() > m_settings->maxLogFilesAmount) {
+        const std::filesystem::path segment = rootPath / std::get<2>(logFilesNames.top());
+        std::filesystem::remove(segment);
+        std::filesystem::remove(LogIndex::GetIndexPath(segment), error);
         logFilesNames.pop();
     }
 }
@@ -0,0 +1,188 @@
+#include <DebugLogArena.h>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    constexpr size_t kBlockAlignment = alignof(std::max_align_t);
+
+    constexpr size_t AlignUp(const size_t size) {
+        return (size + kBlockAlignment - 1) & ~(kBlockAlignment - 1);
+    }
+}
+
+struct Debug::RecordArena::Slab {
+    RecordArena*        arena;
+    Slab*               next;
+    size_t              capacity;
+    size_t              used;
+    // Live blocks, plus one while a producer thread is still filling the slab.
+    std::atomic<size_t> references;
+
+    unsigned char* Data() {
+        return reinterpret_cast<unsigned char*>(this) + AlignUp(sizeof(Slab));
+    }
+
+    void Unref() {
+        if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            arena->Recycle(this);
+        }
+    }
+};
+
+struct Debug::RecordArena::ThreadSlab {
+    RecordArena* arena = nullptr;
+    Slab*        slab  = nullptr;
+
+    ~ThreadSlab() {
+        Reset();
+    }
+
+    void Reset() {
+        if (slab) {
+            slab->Unref();
+        }
+        slab = nullptr;
+        arena = nullptr;
+    }
+};
+
+namespace {
+    struct BlockHeader {
+        void* slab;
+    };
+
+    constexpr size_t kBlockHeaderSize = AlignUp(sizeof(BlockHeader));
+}
+
+Debug::RecordArena::RecordArena(const size_t memoryLimit)
+    : m_freeSlabs(nullptr), m_memoryLimit(memoryLimit), m_reservedBytes(0) { }
+
+Debug::RecordArena::~RecordArena() {
+    if (ThreadSlab& current = GetThreadSlab(); current.arena == this) {
+        current.Reset();
+    }
+
+    while (m_freeSlabs) {
+        Slab* slab = m_freeSlabs;
+        m_freeSlabs = slab->next;
+        FreeSlab(slab);
+    }
+}
+
+void* Debug::RecordArena::Allocate(const size_t size) {
+    const size_t total = kBlockHeaderSize + AlignUp(size);
+
+    Slab* slab;
+    if (total > SlabSize) {
+        // Oversized records get a dedicated slab that is freed, not pooled,
+        // once the record is released. It still counts against the limit.
+        slab = AcquireSlab(total);
+        if (!slab) return nullptr;
+        slab->references.store(0, std::memory_order_relaxed);
+    } else {
+        ThreadSlab& current = GetThreadSlab();
+        if (current.arena != this) {
+            current.Reset();
+            current.arena = this;
+        }
+
+        if (!current.slab || current.slab->used + total > current.slab->capacity) {
+            Slab* next = AcquireSlab(SlabSize);
+            if (!next) return nullptr;
+
+            next->references.store(1, std::memory_order_relaxed);
+            if (current.slab) current.slab->Unref();
+            current.slab = next;
+        }
+        slab = current.slab;
+    }
+
+    slab->references.fetch_add(1, std::memory_order_relaxed);
+    auto* header = reinterpret_cast<BlockHeader*>(slab->Data() + slab->used);
+    header->slab = slab;
+    slab->used += total;
+
+    return reinterpret_cast<unsigned char*>(header) + kBlockHeaderSize;
+}
+
+void Debug::RecordArena::Release(void* block) {
+    if (!block) return;
+
+    const auto* header = reinterpret_cast<const BlockHeader*>(static_cast<unsigned char*>(block) - kBlockHeaderSize);
+    static_cast<Slab*>(header->slab)->Unref();
+}
+
+void Debug::RecordArena::SetMemoryLimit(const size_t memoryLimit) {
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    m_memoryLimit = memoryLimit;
+
+    while (m_freeSlabs && m_reservedBytes > m_memoryLimit) {
+        Slab* slab = m_freeSlabs;
+        m_freeSlabs = slab->next;
+        m_reservedBytes -= AlignUp(sizeof(Slab)) + slab->capacity;
+        FreeSlab(slab);
+    }
+}
+
+size_t Debug::RecordArena::GetMemoryLimit() const {
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    return m_memoryLimit;
+}
+
+size_t Debug::RecordArena::GetReservedBytes() const {
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    return m_reservedBytes;
+}
+
+Debug::RecordArena::ThreadSlab& Debug::RecordArena::GetThreadSlab() {
+    thread_local ThreadSlab threadSlab;
+    return threadSlab;
+}
+
+Debug::RecordArena::Slab* Debug::RecordArena::AcquireSlab(const size_t capacity) {
+    const size_t footprint = AlignUp(sizeof(Slab)) + capacity;
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        if (capacity == SlabSize && m_freeSlabs) {
+            Slab* slab = m_freeSlabs;
+            m_freeSlabs = slab->next;
+            slab->next = nullptr;
+            slab->used = 0;
+            return slab;
+        }
+
+        if (m_reservedBytes + footprint > m_memoryLimit) {
+            return nullptr;
+        }
+        m_reservedBytes += footprint;
+    }
+
+    void* memory = std::malloc(footprint);
+    if (!memory) {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        m_reservedBytes -= footprint;
+        return nullptr;
+    }
+
+    return new (memory) Slab{this, nullptr, capacity, 0, {0}};
+}
+
+void Debug::RecordArena::Recycle(Slab* slab) {
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        if (slab->capacity == SlabSize && m_reservedBytes <= m_memoryLimit) {
+            slab->used = 0;
+            slab->next = m_freeSlabs;
+            m_freeSlabs = slab;
+            return;
+        }
+        m_reservedBytes -= AlignUp(sizeof(Slab)) + slab->capacity;
+    }
+
+    FreeSlab(slab);
+}
+
+void Debug::RecordArena::FreeSlab(Slab* slab) {
+    slab->~Slab();
+    std::free(slab);
+}
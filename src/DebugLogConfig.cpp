@@ -0,0 +1,229 @@
+#include <DebugLogConfig.h>
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::string_view Trim(std::string_view text) {
+        constexpr std::string_view whitespace = " \t\r\n";
+        const size_t first = text.find_first_not_of(whitespace);
+        if (first == std::string_view::npos) {
+            return {};
+        }
+        return text.substr(first, text.find_last_not_of(whitespace) - first + 1);
+    }
+
+    size_t ParseSize(const std::string_view value) {
+        uint64_t result = 0;
+        const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (value.empty() || error != std::errc() || end != value.data() + value.size()) {
+            throw std::runtime_error(fmt::format("'{}' is not a size", value));
+        }
+        return static_cast<size_t>(result);
+    }
+
+    bool ParseBool(const std::string_view value) {
+        if (value == "true") return true;
+        if (value == "false") return false;
+        throw std::runtime_error(fmt::format("'{}' is not true or false", value));
+    }
+
+    Debug::LogLevel ParseLevel(const std::string_view value) {
+        if (value == "DEFAULT_DEBUG_LOG") return Debug::LogLevel::DEFAULT_DEBUG_LOG;
+        if (value == "WARNING_DEBUG_LOG") return Debug::LogLevel::WARNING_DEBUG_LOG;
+        if (value == "ERROR_DEBUG_LOG") return Debug::LogLevel::ERROR_DEBUG_LOG;
+        throw std::runtime_error(fmt::format("'{}' is not a log level", value));
+    }
+
+    Debug::RotationPolicy ParseRotationPolicy(const std::string_view value) {
+        if (value == "SIZE_ROTATION") return Debug::RotationPolicy::SIZE_ROTATION;
+        if (value == "HOURLY_ROTATION") return Debug::RotationPolicy::HOURLY_ROTATION;
+        if (value == "DAILY_ROTATION") return Debug::RotationPolicy::DAILY_ROTATION;
+        if (value == "SIZE_OR_HOURLY_ROTATION") return Debug::RotationPolicy::SIZE_OR_HOURLY_ROTATION;
+        if (value == "SIZE_OR_DAILY_ROTATION") return Debug::RotationPolicy::SIZE_OR_DAILY_ROTATION;
+        throw std::runtime_error(fmt::format("'{}' is not a rotation policy", value));
+    }
+
+    void Assign(Debug::Settings& settings, const std::string_view name, const std::string_view value) {
+        if (name == "rootPath")               settings.rootPath = std::string(value);
+        else if (name == "maxFileSize")       settings.maxFileSize = ParseSize(value);
+        else if (name == "maxLogFilesAmount") settings.maxLogFilesAmount = ParseSize(value);
+        else if (name == "deleteLogsAfter")   settings.deleteLogsAfter = ParseSize(value);
+        else if (name == "asynchronous")      settings.asynchronous = ParseBool(value);
+        else if (name == "asyncMemoryLimit")  settings.asyncMemoryLimit = ParseSize(value);
+        else if (name == "flushOnEveryWrite") settings.flushOnEveryWrite = ParseBool(value);
+        else if (name == "rotationPolicy")    settings.rotationPolicy = ParseRotationPolicy(value);
+        else if (name == "indexInterval")     settings.indexInterval = ParseSize(value);
+        else if (name == "statsInterval")     settings.statsInterval = ParseSize(value);
+        else if (name == "sourceLocation")    settings.sourceLocation = ParseBool(value);
+        else if (name == "minLevel")          settings.minLevel = ParseLevel(value);
+        else if (name == "pattern")           settings.pattern = std::string(value);
+        else throw std::runtime_error(fmt::format("unknown setting '{}'", name));
+    }
+}
+
+Debug::ConfigWatcher::ConfigWatcher(std::filesystem::path path, const std::chrono::milliseconds pollInterval)
+    : m_path(std::move(path)), m_base(*GetSettings()), m_pollInterval(pollInterval), m_reloads(0),
+      m_inotify(-1), m_wakeup{-1, -1}, m_stopping(false) {
+#if defined(__linux__)
+    // Editors usually replace the file rather than write it in place, so the
+    // directory is watched for the name instead of the file itself. The
+    // watch exists before the first read, so no change is missed.
+    std::filesystem::path directory = m_path.parent_path();
+    if (directory.empty()) {
+        directory = ".";
+    }
+
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify >= 0 && (inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0
+                           || pipe2(m_wakeup, O_CLOEXEC) < 0)) {
+        ::close(m_inotify);
+        m_inotify = -1;
+    }
+#endif
+
+    std::error_code error;
+    m_lastWrite = std::filesystem::last_write_time(m_path, error);
+    Reload();
+
+    m_thread = std::thread(&ConfigWatcher::WatchLoop, this);
+}
+
+Debug::ConfigWatcher::~ConfigWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+#if defined(__linux__)
+    if (m_inotify >= 0) {
+        const char stop = 0;
+        (void)::write(m_wakeup[1], &stop, 1);
+    }
+#endif
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+#if defined(__linux__)
+    if (m_inotify >= 0) {
+        ::close(m_inotify);
+        ::close(m_wakeup[0]);
+        ::close(m_wakeup[1]);
+    }
+#endif
+}
+
+Debug::Settings Debug::ConfigWatcher::Parse(std::istream& input, Settings base) {
+    std::string line;
+    for (size_t number = 1; std::getline(input, line); ++number) {
+        const std::string_view text = Trim(line);
+        if (text.empty() || text.front() == '#') {
+            continue;
+        }
+
+        const size_t separator = text.find('=');
+        if (separator == std::string_view::npos) {
+            throw std::runtime_error(fmt::format("line {}: expected name = value", number));
+        }
+
+        try {
+            Assign(base, Trim(text.substr(0, separator)), Trim(text.substr(separator + 1)));
+        } catch (const std::runtime_error& exception) {
+            throw std::runtime_error(fmt::format("line {}: {}", number, exception.what()));
+        }
+    }
+    return base;
+}
+
+const std::filesystem::path& Debug::ConfigWatcher::GetPath() const {
+    return m_path;
+}
+
+uint64_t Debug::ConfigWatcher::GetReloadCount() const {
+    return m_reloads.load(std::memory_order_acquire);
+}
+
+void Debug::ConfigWatcher::Reload() {
+    // A missing file is not an error; the logger keeps its settings until
+    // the file appears.
+    std::ifstream input(m_path);
+    if (!input) {
+        return;
+    }
+
+    try {
+        SetSettings(Parse(input, m_base));
+        m_reloads.fetch_add(1, std::memory_order_release);
+    } catch (const std::exception& exception) {
+        LogWarning(fmt::format("Ignoring {}: {}", m_path.string(), exception.what()));
+    }
+}
+
+void Debug::ConfigWatcher::WatchLoop() {
+    if (m_inotify >= 0) {
+        WatchInotify();
+    } else {
+        PollModificationTime();
+    }
+}
+
+void Debug::ConfigWatcher::WatchInotify() {
+#if defined(__linux__)
+    const std::string name = m_path.filename().string();
+    alignas(inotify_event) char events[4096];
+
+    while (true) {
+        pollfd descriptors[2] = {{m_inotify, POLLIN, 0}, {m_wakeup[0], POLLIN, 0}};
+        if (poll(descriptors, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (descriptors[1].revents != 0) {
+            return;
+        }
+
+        // One save may produce several events; the file is read once.
+        bool changed = false;
+        ssize_t size;
+        while ((size = ::read(m_inotify, events, sizeof(events))) > 0) {
+            for (const char* position = events; position < events + size;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(position);
+                changed = changed || (event->len > 0 && name == event->name);
+                position += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        if (changed) {
+            Reload();
+        }
+    }
+#endif
+}
+
+void Debug::ConfigWatcher::PollModificationTime() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_condition.wait_for(lock, m_pollInterval, [this] { return m_stopping; })) {
+        std::error_code error;
+        const std::filesystem::file_time_type lastWrite = std::filesystem::last_write_time(m_path, error);
+        if (error || lastWrite == m_lastWrite) {
+            continue;
+        }
+
+        m_lastWrite = lastWrite;
+        lock.unlock();
+        Reload();
+        lock.lock();
+    }
+}
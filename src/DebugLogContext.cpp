@@ -0,0 +1,41 @@
+#include <DebugLog.h>
+
+namespace {
+    std::vector<Debug::Context::Field> JoinFields(const Debug::Context* parent, const std::initializer_list<Debug::Context::Field> fields) {
+        std::vector<Debug::Context::Field> joined;
+        if (parent) {
+            joined = parent->fields;
+        }
+        joined.insert(joined.end(), fields.begin(), fields.end());
+        return joined;
+    }
+
+    std::string RenderFields(const std::vector<Debug::Context::Field>& fields) {
+        fmt::memory_buffer text;
+        for (const Debug::Context::Field& field : fields) {
+            if (text.size() > 0) {
+                text.push_back(' ');
+            }
+            fmt::format_to(fmt::appender(text), "{}={}", field.key, field.value);
+        }
+        return fmt::to_string(text);
+    }
+}
+
+Debug::Context::Context(const Context* parent, const std::initializer_list<Field> fields)
+    : fields(JoinFields(parent, fields)), text(RenderFields(this->fields)) { }
+
+Debug::ScopedContext::ScopedContext(const std::initializer_list<Context::Field> fields) {
+    std::shared_ptr<const Context>& current = GetCurrentContext();
+    m_previous = current;
+    current = std::make_shared<const Context>(m_previous.get(), fields);
+}
+
+Debug::ScopedContext::~ScopedContext() {
+    GetCurrentContext() = std::move(m_previous);
+}
+
+std::shared_ptr<const Debug::Context>& Debug::GetCurrentContext() {
+    thread_local std::shared_ptr<const Context> context;
+    return context;
+}
@@ -0,0 +1,356 @@
+#include <DebugLog.h>
+#include <DebugLogSinks.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#if !defined(_WIN32)
+#include <csignal>
+#include <signal.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define DEBUG_LOG_HAS_BACKTRACE
+#endif
+#endif
+
+#if !defined(_WIN32)
+namespace {
+    constexpr int kFatalSignals[] = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL};
+    constexpr size_t kSignalCount = sizeof(kFatalSignals) / sizeof(kFatalSignals[0]);
+
+    std::mutex          installMutex;
+    std::atomic<bool>   installed{false};
+    struct sigaction    previousActions[kSignalCount];
+    std::atomic<bool>   handling{false};
+    std::atomic<long>   utcOffset{0};
+    // Guarded by m_mutex, so that no AddSink falls between installing the
+    // handler and publishing the sinks it sees.
+    bool                publishSinks = false;
+
+    // Large enough for the handler. A thread that overflows its own stack
+    // can only run the handler on an alternate one, which sigaltstack sets
+    // per thread; see InstallAlternateStack.
+    constexpr size_t kAlternateStackSize = 64 * 1024;
+
+    class AlternateStack {
+    public:
+        AlternateStack() {
+            // A stack the application installed itself is left alone.
+            stack_t current{};
+            if (sigaltstack(nullptr, &current) != 0 || !(current.ss_flags & SS_DISABLE)) {
+                return;
+            }
+
+            m_memory.reset(new char[kAlternateStackSize]);
+            stack_t stack{};
+            stack.ss_sp = m_memory.get();
+            stack.ss_size = kAlternateStackSize;
+            if (sigaltstack(&stack, nullptr) != 0) {
+                m_memory.reset();
+            }
+        }
+
+        ~AlternateStack() {
+            if (m_memory) {
+                stack_t stack{};
+                stack.ss_flags = SS_DISABLE;
+                sigaltstack(&stack, nullptr);
+            }
+        }
+
+        AlternateStack(const AlternateStack&) = delete;
+        AlternateStack& operator=(const AlternateStack&) = delete;
+
+    private:
+        std::unique_ptr<char[]> m_memory;
+    };
+
+    // Everything below runs inside the signal handler: fixed buffers and
+    // hand-written number formatting instead of fmt and strftime.
+    template <size_t Capacity = 8 * 1024>
+    class ReportBuffer {
+    public:
+        void Append(const char* text) {
+            Append(text, std::strlen(text));
+        }
+
+        void Append(const std::string_view text) {
+            Append(text.data(), text.size());
+        }
+
+        void Append(const char* text, size_t size) {
+            size = std::min(size, sizeof(m_data) - m_size);
+            std::memcpy(m_data + m_size, text, size);
+            m_size += size;
+        }
+
+        void AppendNumber(uint64_t value, const unsigned base, const size_t minDigits) {
+            char digits[32];
+            size_t count = 0;
+            do {
+                digits[count++] = "0123456789abcdef"[value % base];
+                value /= base;
+            } while (value > 0 && count < sizeof(digits));
+            while (count < minDigits && count < sizeof(digits)) {
+                digits[count++] = '0';
+            }
+            while (count > 0) {
+                Append(&digits[--count], 1);
+            }
+        }
+
+        void Clear() { m_size = 0; }
+
+        NO_DISCARD std::string_view View() const { return {m_data, m_size}; }
+
+    private:
+        char   m_data[Capacity];
+        size_t m_size = 0;
+    };
+
+    ReportBuffer<> report;
+
+    // A queued record's line with its context, as Sink::AppendLine renders
+    // it. Context::text was rendered when the scope was entered, so this is
+    // only a copy; a line too long for the buffer goes without its context.
+    ReportBuffer<64 * 1024> contextLine;
+
+    std::string_view LineWithContext(const Debug::Record& record) {
+        if (!record.context) {
+            return record.text;
+        }
+
+        const std::string_view context = record.context->text;
+        if (record.text.size() + context.size() + 3 > 64 * 1024) {
+            return record.text;
+        }
+
+        const size_t messageOffset = static_cast<size_t>(record.message.data() - record.text.data());
+        contextLine.Clear();
+        contextLine.Append(record.text.substr(0, messageOffset));
+        contextLine.Append("[");
+        contextLine.Append(context);
+        contextLine.Append("] ");
+        contextLine.Append(record.text.substr(messageOffset));
+        return contextLine.View();
+    }
+
+    const char* SignalName(const int signal) {
+        switch (signal) {
+            case SIGSEGV: return "SIGSEGV";
+            case SIGABRT: return "SIGABRT";
+            case SIGBUS:  return "SIGBUS";
+            case SIGFPE:  return "SIGFPE";
+            case SIGILL:  return "SIGILL";
+            default:      return "UNKNOWN";
+        }
+    }
+
+    // Same layout as the timestamps of regular records. localtime_r is not
+    // async-signal-safe, so the local offset is taken when the handler is
+    // installed and the calendar date is computed by hand.
+    void AppendTimestamp(ReportBuffer<>& buffer) {
+        const long long local = static_cast<long long>(std::time(nullptr)) + utcOffset.load(std::memory_order_relaxed);
+        long long days = local / 86400;
+        long long seconds = local % 86400;
+        if (seconds < 0) {
+            seconds += 86400;
+            days--;
+        }
+
+        // Civil-from-days, see https://howardhinnant.github.io/date_algorithms.html
+        days += 719468;
+        const long long era = (days >= 0 ? days : days - 146096) / 146097;
+        const long long dayOfEra = days - era * 146097;
+        const long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        const long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const long long monthIndex = (5 * dayOfYear + 2) / 153;
+        const long long day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+        const long long month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+        const long long year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+        buffer.AppendNumber(static_cast<uint64_t>(year), 10, 4);
+        buffer.Append("-");
+        buffer.AppendNumber(static_cast<uint64_t>(month), 10, 2);
+        buffer.Append("-");
+        buffer.AppendNumber(static_cast<uint64_t>(day), 10, 2);
+        buffer.Append("_");
+        buffer.AppendNumber(static_cast<uint64_t>(seconds / 3600), 10, 2);
+        buffer.Append("-");
+        buffer.AppendNumber(static_cast<uint64_t>(seconds / 60 % 60), 10, 2);
+        buffer.Append("-");
+        buffer.AppendNumber(static_cast<uint64_t>(seconds % 60), 10, 2);
+    }
+}
+#endif // !_WIN32
+
+void Debug::InstallCrashHandler() {
+#if !defined(_WIN32)
+    std::lock_guard<std::mutex> lock(installMutex);
+    if (installed.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    const std::time_t now = std::time(nullptr);
+    std::tm localTime{};
+    localtime_r(&now, &localTime);
+    utcOffset.store(localTime.tm_gmtoff, std::memory_order_relaxed);
+
+#ifdef DEBUG_LOG_HAS_BACKTRACE
+    // The first call loads the unwinder, which allocates; do it here rather
+    // than in the handler.
+    void* frames[1];
+    backtrace(frames, 1);
+#endif
+
+    // The handler only ever sees published sinks.
+    {
+        std::lock_guard<std::mutex> sinksLock(m_mutex);
+        publishSinks = true;
+        PublishSinksLocked();
+    }
+
+    struct sigaction action{};
+    action.sa_handler = HandleFatalSignal;
+    action.sa_flags = SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+
+    for (size_t i = 0; i < kSignalCount; ++i) {
+        sigaction(kFatalSignals[i], &action, &previousActions[i]);
+    }
+    installed.store(true, std::memory_order_relaxed);
+    InstallAlternateStack();
+#endif // !_WIN32
+}
+
+void Debug::UninstallCrashHandler() {
+#if !defined(_WIN32)
+    std::lock_guard<std::mutex> lock(installMutex);
+    if (!installed.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    for (size_t i = 0; i < kSignalCount; ++i) {
+        sigaction(kFatalSignals[i], &previousActions[i], nullptr);
+    }
+    installed.store(false, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> sinksLock(m_mutex);
+    publishSinks = false;
+#endif // !_WIN32
+}
+
+void Debug::InstallAlternateStack() {
+#if !defined(_WIN32)
+    // Once per thread, and only while the handler is installed; the stack
+    // is released when the thread exits.
+    thread_local bool done = false;
+    if (done || !installed.load(std::memory_order_relaxed)) {
+        return;
+    }
+    done = true;
+    thread_local AlternateStack stack;
+    (void)stack;
+#endif // !_WIN32
+}
+
+void Debug::PublishSinksLocked() {
+#if !defined(_WIN32)
+    // Without a handler there is nobody to publish to; InstallCrashHandler
+    // publishes the sinks of the time.
+    if (!publishSinks) {
+        return;
+    }
+
+    // A handler may still be walking the previous array, so none is freed,
+    // not even at exit; sinks change rarely.
+    static auto& published = *new std::vector<std::unique_ptr<const std::vector<Sink*>>>();
+
+    auto sinks = std::make_unique<std::vector<Sink*>>();
+    for (const std::shared_ptr<Sink>& sink : m_sinks) {
+        sinks->push_back(sink.get());
+    }
+    published.push_back(std::move(sinks));
+    m_signalSinks.store(published.back().get(), std::memory_order_release);
+#endif // !_WIN32
+}
+
+void Debug::HandleFatalSignal(const int signal) noexcept {
+#if !defined(_WIN32)
+    // A second thread crashing meanwhile waits for the first to take the
+    // process down.
+    if (handling.exchange(true)) {
+        for (;;) pause();
+    }
+
+    // Nothing here takes m_mutex: the crashing thread may hold it, or be in
+    // the middle of changing m_sinks. Sinks are flushed first so that the
+    // queued records land after what was already accepted.
+    const std::vector<Sink*>& sinks = *m_signalSinks.load(std::memory_order_acquire);
+    for (Sink* sink : sinks) {
+        sink->FlushFromSignal();
+    }
+
+    // The queue is a LIFO stack; reverse it in place to restore the logging
+    // order. The records are never released, the process is going down.
+    const Record* queued = m_queueHead.exchange(nullptr, std::memory_order_acquire);
+    const Record* ordered = nullptr;
+    while (queued) {
+        const Record* next = queued->m_next;
+        queued->m_next = ordered;
+        ordered = queued;
+        queued = next;
+    }
+    for (; ordered; ordered = ordered->m_next) {
+        // Rendering a compact event would allocate; it is lost.
+        if (ordered->m_renderer) {
+            continue;
+        }
+        const std::string_view line = LineWithContext(*ordered);
+        for (Sink* sink : sinks) {
+            sink->WriteFromSignal(ordered->level, line);
+        }
+    }
+
+    report.Append("[");
+    report.Append(LogTypeToString(LogLevel::ERROR_DEBUG_LOG));
+    report.Append("   ");
+    AppendTimestamp(report);
+    report.Append("] Fatal signal ");
+    report.AppendNumber(static_cast<uint64_t>(signal), 10, 1);
+    report.Append(" (");
+    report.Append(SignalName(signal));
+    report.Append(")\nStacktrace ( \n");
+
+#ifdef DEBUG_LOG_HAS_BACKTRACE
+    void* frames[64];
+    const int frameCount = backtrace(frames, 64);
+    for (int i = 0; i < frameCount; ++i) {
+        report.Append(i < 10 ? " " : "");
+        report.AppendNumber(static_cast<uint64_t>(i), 10, 1);
+        report.Append("# 0x");
+        report.AppendNumber(reinterpret_cast<uintptr_t>(frames[i]), 16, 2 * sizeof(void*));
+        report.Append("\n");
+    }
+#endif
+    report.Append(")");
+
+    for (Sink* sink : sinks) {
+        sink->WriteFromSignal(LogLevel::ERROR_DEBUG_LOG, report.View());
+    }
+
+    // Hand the signal to whoever had it before; returning re-executes the
+    // faulting instruction or delivers the pending raise().
+    for (size_t i = 0; i < kSignalCount; ++i) {
+        if (kFatalSignals[i] == signal) {
+            sigaction(signal, &previousActions[i], nullptr);
+        }
+    }
+    raise(signal);
+#else
+    (void)signal;
+#endif // !_WIN32
+}
@@ -0,0 +1,222 @@
+#include <DebugLogIndex.h>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <tuple>
+
+namespace {
+    constexpr size_t kTimestampLength = 19; // YYYY-MM-DD_HH-MM-SS
+    constexpr size_t kLevelWidth      = 8;
+
+    bool ParseDigits(const std::string_view text, const size_t position, const size_t count, int& value) {
+        value = 0;
+        for (size_t i = position; i < position + count; ++i) {
+            if (text[i] < '0' || text[i] > '9') return false;
+            value = value * 10 + (text[i] - '0');
+        }
+        return true;
+    }
+
+    int64_t ToNanoseconds(const std::chrono::system_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+}
+
+std::filesystem::path Debug::LogIndex::GetIndexPath(const std::filesystem::path& segment) {
+    std::filesystem::path index = segment;
+    index.replace_extension(".idx");
+    return index;
+}
+
+std::vector<Debug::LogIndex::Entry> Debug::LogIndex::Load(const std::filesystem::path& segment) {
+    std::vector<Entry> entries;
+
+    std::ifstream in(GetIndexPath(segment), std::ios::binary);
+    if (!in.is_open()) {
+        return entries;
+    }
+
+    Entry entry{};
+    while (in.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+uint64_t Debug::LogIndex::FindOffset(const std::filesystem::path& segment, const std::chrono::system_clock::time_point start) {
+    const std::vector<Entry> entries = Load(segment);
+    const int64_t startTime = ToNanoseconds(start);
+
+    // The last entry before which everything is older than start.
+    const auto it = std::partition_point(entries.begin(), entries.end(), [startTime](const Entry& entry) {
+        return entry.maxTimeBefore < startTime;
+    });
+    return it == entries.begin() ? 0 : std::prev(it)->offset;
+}
+
+std::vector<std::filesystem::path> Debug::LogIndex::ListSegments(const std::filesystem::path& directory) {
+    std::vector<std::tuple<std::chrono::system_clock::time_point, uint64_t, std::filesystem::path>> segments;
+
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+        const std::string name = file.path().filename().string();
+        if (!file.is_regular_file() || file.path().extension() != ".log" || name.find(".flight") != std::string::npos) {
+            continue;
+        }
+
+        try {
+            std::chrono::system_clock::time_point time;
+            uint64_t sequence = 0;
+            ParseSegmentName(name, time, sequence);
+            segments.emplace_back(time, sequence, file.path());
+        } catch (...) { }
+    }
+
+    std::sort(segments.begin(), segments.end());
+
+    std::vector<std::filesystem::path> paths;
+    for (const auto& segment : segments) {
+        paths.push_back(std::get<2>(segment));
+    }
+    return paths;
+}
+
+std::vector<std::filesystem::path> Debug::LogIndex::CollectSegments(const std::filesystem::path& path) {
+    if (!std::filesystem::is_directory(path)) {
+        return {path};
+    }
+
+    std::vector<std::filesystem::path> directories{path};
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(path, error);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (!it->is_directory()) {
+            continue;
+        }
+        if (it->path().filename() == "errors" && std::filesystem::is_directory(it->path().parent_path() / "all")) {
+            it.disable_recursion_pending();
+            continue;
+        }
+        directories.push_back(it->path());
+    }
+    std::sort(directories.begin() + 1, directories.end());
+
+    std::vector<std::filesystem::path> segments;
+    for (const auto& directory : directories) {
+        const auto found = ListSegments(directory);
+        segments.insert(segments.end(), found.begin(), found.end());
+    }
+    return segments;
+}
+
+size_t Debug::LogIndex::ReadRange(const std::filesystem::path& directory,
+                                  const std::chrono::system_clock::time_point start,
+                                  const std::chrono::system_clock::time_point end,
+                                  const std::function<void(std::string_view)>& onRecord) {
+    // Record timestamps are rendered to the second.
+    const auto firstSecond = std::chrono::floor<std::chrono::seconds>(start);
+    // Records from different threads may be written slightly out of order;
+    // reading stops only well past the end.
+    const auto stopAfter = end < std::chrono::system_clock::time_point::max() - std::chrono::seconds(1)
+                               ? end + std::chrono::seconds(1)
+                               : end;
+
+    const std::vector<std::filesystem::path> segments = ListSegments(directory);
+    size_t count = 0;
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        // Every record of a segment was created before the next segment was
+        // opened, so segments followed by one opened before start are skipped.
+        if (i + 1 < segments.size()) {
+            std::chrono::system_clock::time_point nextOpened;
+            uint64_t sequence = 0;
+            ParseSegmentName(segments[i + 1].filename().string(), nextOpened, sequence);
+            if (nextOpened + std::chrono::milliseconds(1) <= firstSecond) {
+                continue;
+            }
+        }
+
+        std::ifstream in(segments[i], std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(FindOffset(segments[i], firstSecond)));
+
+        std::string record;
+        std::chrono::system_clock::time_point recordTime{};
+        bool stop = false;
+
+        auto emit = [&]() {
+            if (record.empty()) return;
+            if (recordTime > stopAfter) {
+                stop = true;
+            } else if (recordTime >= firstSecond && recordTime <= end) {
+                onRecord(record);
+                count++;
+            }
+            record.clear();
+        };
+
+        for (std::string line; !stop && std::getline(in, line);) {
+            std::chrono::system_clock::time_point lineTime;
+            if (ParseRecordTime(line, lineTime)) {
+                emit();
+                recordTime = lineTime;
+                record = std::move(line);
+            } else if (!record.empty()) {
+                record += '\n';
+                record += line;
+            }
+        }
+        if (!stop) {
+            emit();
+        }
+        if (stop) {
+            break;
+        }
+    }
+
+    return count;
+}
+
+bool Debug::LogIndex::ParseTime(const std::string_view text, std::chrono::system_clock::time_point& time) {
+    if (text.size() < kTimestampLength || text[4] != '-' || text[7] != '-' || text[10] != '_'
+        || text[13] != '-' || text[16] != '-') {
+        return false;
+    }
+
+    // Lines of the same second share the conversion.
+    thread_local char cachedText[kTimestampLength]{};
+    thread_local std::chrono::system_clock::time_point cachedTime{};
+    if (std::memcmp(cachedText, text.data(), kTimestampLength) == 0) {
+        time = cachedTime;
+        return true;
+    }
+
+    std::tm tm{};
+    if (!ParseDigits(text, 0, 4, tm.tm_year) || !ParseDigits(text, 5, 2, tm.tm_mon) || !ParseDigits(text, 8, 2, tm.tm_mday)
+        || !ParseDigits(text, 11, 2, tm.tm_hour) || !ParseDigits(text, 14, 2, tm.tm_min) || !ParseDigits(text, 17, 2, tm.tm_sec)) {
+        return false;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+
+    time = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    std::memcpy(cachedText, text.data(), kTimestampLength);
+    cachedTime = time;
+    return true;
+}
+
+bool Debug::LogIndex::ParseRecordTime(const std::string_view line, std::chrono::system_clock::time_point& time) {
+    // "[" + level padded to 8 + timestamp + "]"
+    constexpr size_t closing = 1 + kLevelWidth + kTimestampLength;
+    if (line.size() <= closing || line[0] != '[' || line[closing] != ']') {
+        return false;
+    }
+
+    const std::string_view level = line.substr(1, kLevelWidth);
+    if (level != "LOG     " && level != "WARNING " && level != "ERROR   ") {
+        return false;
+    }
+    return ParseTime(line.substr(1 + kLevelWidth, kTimestampLength), time);
+}
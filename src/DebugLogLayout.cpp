@@ -0,0 +1,197 @@
+#include <DebugLog.h>
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+// A Settings::pattern compiled into a flat list of operations. Literal text
+// is kept in one string and copied with a single append; level names are
+// padded once, here, instead of on every line. Settings::sourceLocation adds
+// "<file>:<line>: " in front of the message unless the pattern already
+// places the file or line itself.
+class Debug::Layout {
+public:
+    enum class Operation : uint8_t {
+        LITERAL,
+        LEVEL,
+        PADDED_LEVEL,
+        TIMESTAMP,
+        THREAD,
+        FILE,
+        LINE,
+        FUNCTION,
+        SOURCE_LOCATION,
+        MESSAGE
+    };
+
+    struct Step {
+        Operation operation;
+        uint32_t  offset; // into m_literals, for LITERAL
+        uint32_t  size;
+    };
+
+    Layout(std::string pattern, const bool sourceLocation)
+        : m_pattern(std::move(pattern)), m_sourceLocation(sourceLocation) {
+        for (size_t i = 0; i < m_pattern.size(); ++i) {
+            if (m_pattern[i] != '%') {
+                AddLiteral(m_pattern[i]);
+                continue;
+            }
+            if (++i == m_pattern.size()) {
+                throw std::runtime_error("Log pattern ends with '%'.");
+            }
+
+            switch (m_pattern[i]) {
+                case '%': AddLiteral('%'); break;
+                case 'l': Add(Operation::LEVEL); break;
+                case 'L': Add(Operation::PADDED_LEVEL); break;
+                case 'T': Add(Operation::TIMESTAMP); break;
+                case 't': Add(Operation::THREAD); break;
+                case 's': Add(Operation::FILE); break;
+                case '#': Add(Operation::LINE); break;
+                case '!': Add(Operation::FUNCTION); break;
+                case 'v':
+                    if (m_message != npos) {
+                        throw std::runtime_error("Log pattern has more than one %v.");
+                    }
+                    m_message = m_steps.size();
+                    Add(Operation::MESSAGE);
+                    break;
+                default:
+                    throw std::runtime_error(fmt::format("Unknown log pattern flag '%{}'.", m_pattern[i]));
+            }
+        }
+
+        // Without %v the message goes at the end.
+        if (m_message == npos) {
+            m_message = m_steps.size();
+            Add(Operation::MESSAGE);
+        }
+
+        const bool placesLocation = std::any_of(m_steps.begin(), m_steps.end(), [](const Step& step) {
+            return step.operation == Operation::FILE || step.operation == Operation::LINE;
+        });
+        if (sourceLocation && !placesLocation) {
+            m_steps.insert(m_steps.begin() + static_cast<std::ptrdiff_t>(m_message), {Operation::SOURCE_LOCATION, 0, 0});
+            ++m_message;
+        }
+
+        for (size_t level = 0; level < 3; ++level) {
+            const std::string_view name = LogTypeToString(static_cast<LogLevel>(level));
+            m_levels[level] = name;
+            m_paddedLevels[level] = fmt::format("{:<8}", name);
+        }
+    }
+
+    NO_DISCARD bool Matches(const Settings& settings) const {
+        return m_pattern == settings.pattern && m_sourceLocation == settings.sourceLocation;
+    }
+
+    void AppendPrefix(fmt::memory_buffer& line, const LogLevel type, const std::chrono::system_clock::time_point time,
+                      const uint64_t thread, const SourceLocation& location) const {
+        Append(line, m_steps.data(), m_steps.data() + m_message, type, time, thread, location);
+    }
+
+    void AppendSuffix(fmt::memory_buffer& line, const LogLevel type, const std::chrono::system_clock::time_point time,
+                      const uint64_t thread, const SourceLocation& location) const {
+        Append(line, m_steps.data() + m_message + 1, m_steps.data() + m_steps.size(), type, time, thread, location);
+    }
+
+private:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    void Add(const Operation operation) {
+        m_steps.push_back({operation, 0, 0});
+    }
+
+    void AddLiteral(const char c) {
+        // Adjacent characters share one step.
+        if (m_steps.empty() || m_steps.back().operation != Operation::LITERAL) {
+            m_steps.push_back({Operation::LITERAL, static_cast<uint32_t>(m_literals.size()), 0});
+        }
+        m_literals.push_back(c);
+        ++m_steps.back().size;
+    }
+
+    void Append(fmt::memory_buffer& line, const Step* begin, const Step* end, const LogLevel type,
+                const std::chrono::system_clock::time_point time, const uint64_t thread, const SourceLocation& location) const {
+        const auto append = [&line](const std::string_view text) {
+            line.append(text.data(), text.data() + text.size());
+        };
+
+        for (const Step* step = begin; step != end; ++step) {
+            switch (step->operation) {
+                case Operation::LITERAL:      append({m_literals.data() + step->offset, step->size}); break;
+                case Operation::LEVEL:        append(m_levels[static_cast<size_t>(type)]); break;
+                case Operation::PADDED_LEVEL: append(m_paddedLevels[static_cast<size_t>(type)]); break;
+                case Operation::TIMESTAMP:    append(GetCachedTimestamp(time)); break;
+                case Operation::THREAD:       append(fmt::format_int(thread).c_str()); break;
+                case Operation::FILE:         append(location.file); break;
+                case Operation::LINE:
+                    if (location.IsKnown()) append(fmt::format_int(location.line).c_str());
+                    break;
+                case Operation::FUNCTION:     append(location.function); break;
+                case Operation::SOURCE_LOCATION:
+                    if (location.IsKnown()) {
+                        append(location.file);
+                        line.push_back(':');
+                        append(fmt::format_int(location.line).c_str());
+                        append(": ");
+                    }
+                    break;
+                case Operation::MESSAGE:      break;
+            }
+        }
+    }
+
+    std::string       m_pattern;
+    bool              m_sourceLocation;
+    std::string       m_literals;
+    std::vector<Step> m_steps;
+    size_t            m_message = npos;
+    std::string_view  m_levels[3];
+    std::string       m_paddedLevels[3];
+};
+
+std::atomic<const Debug::Layout*> Debug::m_layout{nullptr};
+
+const Debug::Layout& Debug::GetLayout() {
+    const Layout* layout = m_layout.load(std::memory_order_acquire);
+    if (layout) {
+        return *layout;
+    }
+
+    // Logging before the first SetSettings.
+    static const Layout* defaultLayout = new Layout(Settings{}.pattern, Settings{}.sourceLocation);
+    return *defaultLayout;
+}
+
+const Debug::Layout* Debug::CompileLayout(const Settings& settings) {
+    // Every layout ever compiled. A logging thread may still be formatting
+    // with the previous one while SetSettings installs the next, so layouts
+    // are never freed; one compiled earlier for the same settings is reused.
+    static std::mutex           layoutsMutex;
+    static std::vector<Layout*> layouts;
+    std::lock_guard<std::mutex> lock(layoutsMutex);
+
+    const auto it = std::find_if(layouts.begin(), layouts.end(), [&settings](const Layout* layout) {
+        return layout->Matches(settings);
+    });
+    if (it != layouts.end()) {
+        return *it;
+    }
+
+    layouts.push_back(new Layout(settings.pattern, settings.sourceLocation));
+    return layouts.back();
+}
+
+void Debug::FormatPrefix(const Layout& layout, fmt::memory_buffer& line, const LogLevel type,
+                         const std::chrono::system_clock::time_point time, const uint64_t thread,
+                         const SourceLocation& location) {
+    layout.AppendPrefix(line, type, time, thread, location);
+}
+
+void Debug::FormatSuffix(const Layout& layout, fmt::memory_buffer& line, const LogLevel type,
+                         const std::chrono::system_clock::time_point time, const uint64_t thread,
+                         const SourceLocation& location) {
+    layout.AppendSuffix(line, type, time, thread, location);
+}
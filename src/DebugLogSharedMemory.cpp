@@ -0,0 +1,294 @@
+#include <DebugLogSharedMemory.h>
+
+#if !defined(_WIN32)
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr uint32_t kRingMagic   = 0x44424c52; // "DBLR"
+    constexpr uint32_t kRingVersion = 1;
+
+    struct EntryHeader {
+        uint32_t length;
+        uint32_t level;
+        int64_t  time;
+    };
+
+    // The ring data starts at a fixed offset after the header.
+    constexpr size_t kDataOffset = 256;
+
+    std::atomic<uint32_t> sinkCounter{0};
+}
+
+// Lives at the start of the shared mapping. Only lock-free atomics, so that
+// both processes can use them on the same memory.
+struct Debug::SharedMemoryRing::Header {
+    std::atomic<uint32_t> magic;
+    uint32_t              version;
+    uint64_t              capacity;
+    int64_t               pid;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint32_t> closed;
+
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+};
+
+std::unique_ptr<Debug::SharedMemoryRing> Debug::SharedMemoryRing::Create(const std::string& name, const size_t capacity) {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The shared ring needs lock-free 64-bit atomics");
+    static_assert(sizeof(Header) <= kDataOffset, "Ring header overlaps the data");
+
+    if (capacity <= sizeof(EntryHeader)) {
+        throw std::runtime_error("Shared memory log ring is too small.");
+    }
+
+    const std::string objectName = "/" + name;
+    int file = shm_open(objectName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (file < 0 && errno == EEXIST) {
+        // Left behind by a process that had the same pid and died.
+        shm_unlink(objectName.c_str());
+        file = shm_open(objectName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    if (file < 0) {
+        throw std::runtime_error("Failed to create shared memory log ring.");
+    }
+
+    const size_t mappedSize = kDataOffset + capacity;
+    void* memory = MAP_FAILED;
+    if (ftruncate(file, static_cast<off_t>(mappedSize)) == 0) {
+        memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+    close(file);
+
+    if (memory == MAP_FAILED) {
+        shm_unlink(objectName.c_str());
+        throw std::runtime_error("Failed to map shared memory log ring.");
+    }
+
+    auto* header = new (memory) Header{};
+    header->version = kRingVersion;
+    header->capacity = capacity;
+    header->pid = getpid();
+
+    // Published last: a collector attaching earlier sees no magic and retries.
+    header->magic.store(kRingMagic, std::memory_order_release);
+
+    return std::unique_ptr<SharedMemoryRing>(new SharedMemoryRing(name, memory, mappedSize));
+}
+
+std::unique_ptr<Debug::SharedMemoryRing> Debug::SharedMemoryRing::Attach(const std::string& name) {
+    const int file = shm_open(("/" + name).c_str(), O_RDWR, 0);
+    if (file < 0) {
+        return nullptr;
+    }
+
+    struct stat info{};
+    void* memory = MAP_FAILED;
+    if (fstat(file, &info) == 0 && static_cast<size_t>(info.st_size) > kDataOffset) {
+        memory = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+    close(file);
+
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+
+    const auto* header = static_cast<const Header*>(memory);
+    if (header->magic.load(std::memory_order_acquire) != kRingMagic || header->version != kRingVersion
+        || kDataOffset + header->capacity != static_cast<size_t>(info.st_size)) {
+        munmap(memory, static_cast<size_t>(info.st_size));
+        return nullptr;
+    }
+
+    return std::unique_ptr<SharedMemoryRing>(new SharedMemoryRing(name, memory, static_cast<size_t>(info.st_size)));
+}
+
+Debug::SharedMemoryRing::SharedMemoryRing(std::string name, void* memory, const size_t mappedSize)
+    : m_name(std::move(name)), m_memory(memory), m_mappedSize(mappedSize),
+      m_header(static_cast<Header*>(memory)), m_data(static_cast<char*>(memory) + kDataOffset) { }
+
+Debug::SharedMemoryRing::~SharedMemoryRing() {
+    munmap(m_memory, m_mappedSize);
+}
+
+bool Debug::SharedMemoryRing::Push(const LogLevel level, const std::chrono::system_clock::time_point time, const std::string_view text) noexcept {
+    const uint64_t capacity = m_header->capacity;
+    const uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    const uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+    const uint64_t size = sizeof(EntryHeader) + text.size();
+
+    if (size > capacity - (head - tail)) {
+        m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const EntryHeader entry{
+        static_cast<uint32_t>(text.size()),
+        static_cast<uint32_t>(level),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count()
+    };
+    Write(head, &entry, sizeof(entry));
+    Write(head + sizeof(entry), text.data(), text.size());
+
+    m_header->head.store(head + size, std::memory_order_release);
+    return true;
+}
+
+void Debug::SharedMemoryRing::AddDropped(const uint64_t count) noexcept {
+    m_header->dropped.fetch_add(count, std::memory_order_relaxed);
+}
+
+void Debug::SharedMemoryRing::MarkClosed() {
+    m_header->closed.store(1, std::memory_order_release);
+}
+
+bool Debug::SharedMemoryRing::Pop(Entry& entry) {
+    const uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+    const uint64_t head = m_header->head.load(std::memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+
+    EntryHeader header{};
+    Read(tail, &header, sizeof(header));
+
+    // The producer is another process; never trust the ring to be intact.
+    if (head - tail < sizeof(header) || header.length > head - tail - sizeof(header)) {
+        m_header->tail.store(head, std::memory_order_release);
+        return false;
+    }
+
+    m_scratch.resize(header.length);
+    Read(tail + sizeof(header), m_scratch.data(), header.length);
+    m_header->tail.store(tail + sizeof(header) + header.length, std::memory_order_release);
+
+    entry.level = static_cast<LogLevel>(std::min<uint32_t>(header.level, static_cast<uint32_t>(LogLevel::ERROR_DEBUG_LOG)));
+    entry.time = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(header.time)));
+    entry.text = m_scratch;
+    return true;
+}
+
+void Debug::SharedMemoryRing::Unlink() const {
+    shm_unlink(("/" + m_name).c_str());
+}
+
+const std::string& Debug::SharedMemoryRing::GetName() const {
+    return m_name;
+}
+
+size_t Debug::SharedMemoryRing::GetCapacity() const {
+    return m_header->capacity;
+}
+
+int Debug::SharedMemoryRing::GetProducerPid() const {
+    return static_cast<int>(m_header->pid);
+}
+
+uint64_t Debug::SharedMemoryRing::GetDroppedCount() const {
+    return m_header->dropped.load(std::memory_order_relaxed);
+}
+
+bool Debug::SharedMemoryRing::IsClosed() const {
+    return m_header->closed.load(std::memory_order_acquire) != 0;
+}
+
+bool Debug::SharedMemoryRing::IsEmpty() const {
+    return m_header->head.load(std::memory_order_acquire) == m_header->tail.load(std::memory_order_acquire);
+}
+
+void Debug::SharedMemoryRing::Read(const uint64_t position, void* out, const size_t size) const {
+    const size_t offset = position % m_header->capacity;
+    const size_t first = std::min<size_t>(size, m_header->capacity - offset);
+    std::memcpy(out, m_data + offset, first);
+    std::memcpy(static_cast<char*>(out) + first, m_data, size - first);
+}
+
+void Debug::SharedMemoryRing::Write(const uint64_t position, const void* data, const size_t size) noexcept {
+    const size_t offset = position % m_header->capacity;
+    const size_t first = std::min<size_t>(size, m_header->capacity - offset);
+    std::memcpy(m_data + offset, data, first);
+    std::memcpy(m_data, static_cast<const char*>(data) + first, size - first);
+}
+
+Debug::SharedMemorySink::SharedMemorySink(std::string channel, const size_t capacity, const LogLevel minLevel)
+    : Sink(minLevel), m_channel(std::move(channel)), m_capacity(capacity), m_pushing(false) { }
+
+Debug::SharedMemorySink::~SharedMemorySink() {
+    if (!m_ring) {
+        return;
+    }
+
+    // The collector unlinks rings it has drained; an empty one can go now.
+    m_ring->MarkClosed();
+    if (m_ring->IsEmpty()) {
+        m_ring->Unlink();
+    }
+}
+
+void Debug::SharedMemorySink::Open(const Settings&) {
+    // The ring outlives Close/Open cycles so that the collector keeps
+    // draining one object per sink.
+    if (m_ring) {
+        return;
+    }
+
+    m_ringName = m_channel + "." + std::to_string(getpid()) + "." + std::to_string(sinkCounter.fetch_add(1));
+    m_ring = SharedMemoryRing::Create(m_ringName, m_capacity);
+}
+
+void Debug::SharedMemorySink::Write(const RecordBatch& records) {
+    if (!m_ring) {
+        return;
+    }
+
+    // Only left set by a crash handler that is taking the process down.
+    if (m_pushing.exchange(true, std::memory_order_acquire)) {
+        m_ring->AddDropped(records.size());
+        CountDropped(records.size());
+        return;
+    }
+
+    for (const Record& record : records) {
+        std::string_view text = record.text;
+        if (record.context) {
+            m_line.clear();
+            AppendLine(m_line, record);
+            text = {m_line.data(), m_line.size()};
+        }
+        if (!m_ring->Push(record.level, record.time, text)) {
+            CountDropped(1);
+        }
+    }
+    m_pushing.store(false, std::memory_order_release);
+}
+
+void Debug::SharedMemorySink::WriteFromSignal(const LogLevel level, const std::string_view text) noexcept {
+    if (!m_ring || !Accepts(level)) {
+        return;
+    }
+
+    // A Write in progress, on this thread or another, owns the ring's head;
+    // pushing now would hand the reader a corrupt entry.
+    if (m_pushing.exchange(true, std::memory_order_acquire)) {
+        m_ring->AddDropped(1);
+        return;
+    }
+
+    m_ring->Push(level, std::chrono::system_clock::now(), text);
+    m_pushing.store(false, std::memory_order_release);
+}
+
+const std::string& Debug::SharedMemorySink::GetRingName() const {
+    return m_ringName;
+}
+
+#endif // !_WIN32
@@ -0,0 +1,481 @@
+#include <DebugLogSinks.h>
+#include <DebugLogIndex.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <climits>
+#include <cerrno>
+#include <ctime>
+#include <limits>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // The escape sequences fmt emits for fg(fmt::color::yellow) and
+    // fg(fmt::color::red), spelled out so that coloring a line is a copy.
+    constexpr std::string_view kWarningColor = "\x1b[38;2;255;255;000m";
+    constexpr std::string_view kErrorColor   = "\x1b[38;2;255;000;000m";
+    constexpr std::string_view kResetColor   = "\x1b[0m";
+
+    void Append(fmt::memory_buffer& buffer, const std::string_view text) {
+        buffer.append(text.data(), text.data() + text.size());
+    }
+}
+
+void Debug::Sink::AppendLine(fmt::memory_buffer& buffer, const Record& record) {
+    if (!record.context) {
+        Append(buffer, record.text);
+        return;
+    }
+
+    const size_t messageOffset = static_cast<size_t>(record.message.data() - record.text.data());
+    Append(buffer, record.text.substr(0, messageOffset));
+    buffer.push_back('[');
+    Append(buffer, record.context->text);
+    Append(buffer, "] ");
+    Append(buffer, record.text.substr(messageOffset));
+}
+
+Debug::ConsoleSink::ConsoleSink(const LogLevel minLevel) : Sink(minLevel) { }
+
+void Debug::ConsoleSink::Write(const RecordBatch& records) {
+    m_buffer.clear();
+
+    for (const Record& record : records) {
+        switch (record.level) {
+        case LogLevel::DEFAULT_DEBUG_LOG:
+            break;
+        case LogLevel::WARNING_DEBUG_LOG:
+            Append(m_buffer, kWarningColor);
+            break;
+        case LogLevel::ERROR_DEBUG_LOG:
+            Append(m_buffer, kErrorColor);
+            break;
+        }
+
+        AppendLine(m_buffer, record);
+
+        if (record.level != LogLevel::DEFAULT_DEBUG_LOG) {
+            Append(m_buffer, kResetColor);
+        }
+        m_buffer.push_back('\n');
+    }
+
+    std::fwrite(m_buffer.data(), 1, m_buffer.size(), stdout);
+}
+
+void Debug::ConsoleSink::Flush() {
+    std::fflush(stdout);
+}
+
+namespace {
+    // Thin wrappers over the POSIX/CRT file API. Unlike streams they are usable
+    // from a signal handler.
+    int OpenFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+        return _wopen(path.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        return ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+#endif
+    }
+
+    bool WriteFile(const int file, const char* data, size_t size) noexcept {
+        while (size > 0) {
+#if defined(_WIN32)
+            const int written = _write(file, data, static_cast<unsigned>(std::min<size_t>(size, INT_MAX)));
+#else
+            const ssize_t written = ::write(file, data, size);
+            if (written < 0 && errno == EINTR) continue;
+#endif
+            if (written <= 0) return false;
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    void CloseFile(const int file) {
+#if defined(_WIN32)
+        _close(file);
+#else
+        ::close(file);
+#endif
+    }
+}
+
+Debug::FileSink::FileSink(std::filesystem::path directory, const LogLevel minLevel, std::string extension, std::string header)
+    : Sink(minLevel), m_directory(std::move(directory)), m_extension(std::move(extension)), m_header(std::move(header)),
+      m_file(-1), m_buffer(BufferSize), m_buffered(0),
+      m_size(0), m_maxFileSize(0), m_sequence(0), m_rotationPolicy(RotationPolicy::SIZE_ROTATION),
+      m_deadline(std::numeric_limits<std::chrono::system_clock::rep>::max()),
+      m_indexFile(-1), m_indexInterval(0), m_indexedSize(0), m_maxTime(0) { }
+
+Debug::FileSink::~FileSink() {
+    Close();
+}
+
+void Debug::FileSink::Open(const Settings& settings) {
+    m_root = settings.rootPath / m_directory;
+    ApplySettings(settings);
+
+    std::filesystem::create_directories(m_root);
+    OpenSegment();
+}
+
+void Debug::FileSink::Close() {
+    Flush();
+
+    const int file = m_file.exchange(-1);
+    if (file >= 0) CloseFile(file);
+    if (m_indexFile >= 0) CloseFile(m_indexFile);
+    m_indexFile = -1;
+    m_size = 0;
+}
+
+void Debug::FileSink::Reconfigure(const Settings& settings) {
+    if (m_file.load(std::memory_order_relaxed) < 0 || settings.rootPath / m_directory != m_root) {
+        Close();
+        Open(settings);
+        return;
+    }
+
+    // The open segment stays; a lower limit or a new policy rotates it at
+    // the next line, and an index is only started with the next segment.
+    const RotationPolicy rotationPolicy = m_rotationPolicy;
+    ApplySettings(settings);
+    if (m_rotationPolicy != rotationPolicy) {
+        m_deadline = NextDeadline(std::chrono::system_clock::now());
+    }
+    if (m_indexInterval == 0 && m_indexFile >= 0) {
+        CloseFile(m_indexFile);
+        m_indexFile = -1;
+    }
+
+    ClearLogs(m_root, m_extension);
+}
+
+void Debug::FileSink::Write(const RecordBatch& records) {
+    for (const Record& record : records) {
+        if (record.context) {
+            m_line.clear();
+            AppendLine(m_line, record);
+            WriteLine(record.time, {m_line.data(), m_line.size()});
+        } else {
+            WriteLine(record.time, record.text);
+        }
+    }
+}
+
+void Debug::FileSink::WriteLine(const std::chrono::system_clock::time_point time, const std::string_view line) {
+    // Rotate before the line that would cross the limit; a segment only
+    // exceeds it when a single line does.
+    const size_t size = line.size() + 1;
+    const bool open = m_file.load(std::memory_order_relaxed) >= 0;
+    if (open && ((m_size > m_header.size() && m_size + size > m_maxFileSize) || time.time_since_epoch().count() >= m_deadline)) {
+        const auto rotationStart = std::chrono::steady_clock::now();
+        Close();
+        OpenSegment();
+        CountRotation(std::chrono::steady_clock::now() - rotationStart);
+    } else if (!open) {
+        OpenSegment();
+    }
+
+    // Every indexInterval bytes the index records where the next line starts
+    // and the newest time written before it.
+    if (m_indexFile >= 0 && (m_size == m_header.size() || m_size - m_indexedSize >= m_indexInterval)) {
+        const LogIndex::Entry entry{m_maxTime, m_size};
+        WriteFile(m_indexFile, reinterpret_cast<const char*>(&entry), sizeof(entry));
+        m_indexedSize = m_size;
+    }
+    m_maxTime = std::max<int64_t>(m_maxTime, std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+
+    Append(line.data(), line.size());
+    Append("\n", 1);
+    m_size += size;
+}
+
+void Debug::FileSink::Flush() {
+    FlushFromSignal();
+}
+
+void Debug::FileSink::FlushFromSignal() noexcept {
+    const size_t buffered = m_buffered.load(std::memory_order_acquire);
+    const int file = m_file.load(std::memory_order_acquire);
+    if (buffered == 0 || file < 0) {
+        return;
+    }
+
+    // A crash in the middle of this write makes the signal handler write the
+    // buffer again; a duplicated chunk is better than a lost one.
+    WriteFile(file, m_buffer.data(), buffered);
+    m_buffered.store(0, std::memory_order_release);
+}
+
+void Debug::FileSink::WriteFromSignal(const LogLevel level, const std::string_view text) noexcept {
+    const int file = m_file.load(std::memory_order_acquire);
+    if (file < 0 || !Accepts(level)) {
+        return;
+    }
+
+    WriteFile(file, text.data(), text.size());
+    WriteFile(file, "\n", 1);
+}
+
+const std::filesystem::path& Debug::FileSink::GetDirectory() const {
+    return m_directory;
+}
+
+void Debug::FileSink::ApplySettings(const Settings& settings) {
+    m_rotationPolicy = settings.rotationPolicy;
+
+    const bool bySize = m_rotationPolicy == RotationPolicy::SIZE_ROTATION
+                        || m_rotationPolicy == RotationPolicy::SIZE_OR_HOURLY_ROTATION
+                        || m_rotationPolicy == RotationPolicy::SIZE_OR_DAILY_ROTATION;
+    m_maxFileSize = bySize ? settings.maxFileSize : std::numeric_limits<size_t>::max();
+    m_indexInterval = settings.indexInterval;
+}
+
+void Debug::FileSink::OpenSegment() {
+    // Segments are always new files. Another process writing to the same
+    // directory may have taken a name; the sequence number moves past it.
+    const auto now = std::chrono::system_clock::now();
+    std::filesystem::path segment;
+    int file = -1;
+    do {
+        segment = m_root / GetSegmentName(now, m_sequence++);
+        segment.replace_extension(m_extension);
+        file = OpenFile(segment);
+    } while (file < 0 && errno == EEXIST);
+    m_size = 0;
+    m_deadline = NextDeadline(now);
+
+    // Without an index the segment is still readable, only not seekable.
+    if (file >= 0 && m_indexInterval > 0) {
+        m_indexFile = OpenFile(LogIndex::GetIndexPath(segment));
+        m_indexedSize = 0;
+        m_maxTime = std::numeric_limits<int64_t>::min();
+    }
+
+    ClearLogs(m_root, m_extension);
+
+    if (file < 0) {
+        throw std::runtime_error("Failed to open log files.");
+    }
+    m_file.store(file, std::memory_order_release);
+
+    Append(m_header.data(), m_header.size());
+    m_size = m_header.size();
+}
+
+std::chrono::system_clock::rep Debug::FileSink::NextDeadline(const std::chrono::system_clock::time_point now) const {
+    const bool hourly = m_rotationPolicy == RotationPolicy::HOURLY_ROTATION
+                        || m_rotationPolicy == RotationPolicy::SIZE_OR_HOURLY_ROTATION;
+    const bool daily = m_rotationPolicy == RotationPolicy::DAILY_ROTATION
+                       || m_rotationPolicy == RotationPolicy::SIZE_OR_DAILY_ROTATION;
+    if (!hourly && !daily) {
+        return std::numeric_limits<std::chrono::system_clock::rep>::max();
+    }
+
+    // Boundaries are in local time, like the segment names; mktime takes
+    // care of daylight saving changes.
+    const std::time_t nowTime = std::chrono::system_clock::to_time_t(now);
+    std::tm boundary{};
+#if defined(_WIN32)
+    localtime_s(&boundary, &nowTime);
+#else
+    localtime_r(&nowTime, &boundary);
+#endif
+
+    boundary.tm_sec = 0;
+    boundary.tm_min = 0;
+    if (daily) {
+        boundary.tm_hour = 0;
+        boundary.tm_mday += 1;
+    } else {
+        boundary.tm_hour += 1;
+    }
+    boundary.tm_isdst = -1;
+
+    return std::chrono::system_clock::from_time_t(std::mktime(&boundary)).time_since_epoch().count();
+}
+
+void Debug::FileSink::Append(const char* data, const size_t size) {
+    size_t buffered = m_buffered.load(std::memory_order_relaxed);
+    if (buffered + size > m_buffer.size()) {
+        Flush();
+        buffered = 0;
+    }
+
+    if (size > m_buffer.size()) {
+        WriteFile(m_file.load(std::memory_order_relaxed), data, size);
+        return;
+    }
+
+    // Publish the new length only after the bytes are in place, so that the
+    // crash handler never writes a half-copied line.
+    std::memcpy(m_buffer.data() + buffered, data, size);
+    m_buffered.store(buffered + size, std::memory_order_release);
+}
+
+namespace {
+    using RecordLength = uint32_t;
+
+    // Dumps are not segments: retention counts them apart from the .log
+    // files in the same directory.
+    constexpr std::string_view kDumpExtension = ".flight";
+}
+
+Debug::FlightRecorderSink::FlightRecorderSink(const size_t capacity, const LogLevel minLevel, const LogLevel dumpLevel, std::filesystem::path directory)
+    : Sink(minLevel), m_ring(capacity), m_head(0), m_tail(0), m_used(0), m_records(0),
+      m_dumpLevel(dumpLevel), m_directory(std::move(directory)), m_sequence(0) { }
+
+void Debug::FlightRecorderSink::Open(const Settings& settings) {
+    m_root = settings.rootPath / m_directory;
+
+    // Nothing may allocate once a fatal signal arrives, so the crash dump
+    // path is prepared up front.
+    std::filesystem::path crashDump = m_root / GetSegmentName(std::chrono::system_clock::now(), m_sequence++);
+    crashDump.replace_extension(std::string(".crash").append(kDumpExtension));
+    m_crashDumpPath = crashDump.string();
+}
+
+void Debug::FlightRecorderSink::Write(const RecordBatch& records) {
+    bool dump = false;
+
+    for (const Record& record : records) {
+        // Each entry is its length followed by the text, so that the oldest
+        // entry can be dropped whole when the ring runs out of space.
+        if (m_ring.size() <= sizeof(RecordLength)) {
+            break;
+        }
+        std::string_view text = record.text;
+        if (record.context) {
+            m_line.clear();
+            AppendLine(m_line, record);
+            text = {m_line.data(), m_line.size()};
+        }
+
+        const size_t maxLength = m_ring.size() - sizeof(RecordLength);
+        const auto length = static_cast<RecordLength>(std::min(text.size(), maxLength));
+
+        while (m_ring.size() - m_used < sizeof(RecordLength) + length) {
+            DropOldest();
+        }
+
+        Push(reinterpret_cast<const char*>(&length), sizeof(length));
+        Push(text.data(), length);
+        m_records++;
+
+        dump |= record.level >= m_dumpLevel;
+    }
+
+    if (dump) {
+        Dump();
+    }
+}
+
+void Debug::FlightRecorderSink::Dump() {
+    if (m_records == 0 || m_root.empty()) {
+        return;
+    }
+
+    // Like segments, every dump is a new file, even within the same second.
+    std::filesystem::create_directories(m_root);
+    const auto now = std::chrono::system_clock::now();
+    int file = -1;
+    do {
+        std::filesystem::path dump = m_root / GetSegmentName(now, m_sequence++);
+        dump.replace_extension(kDumpExtension);
+        file = OpenFile(dump);
+    } while (file < 0 && errno == EEXIST);
+    if (file < 0) {
+        throw std::runtime_error("Failed to open flight recorder dump file.");
+    }
+
+    while (m_records > 0) {
+        RecordLength length;
+        Copy(m_tail, reinterpret_cast<char*>(&length), sizeof(length));
+
+        const size_t position = (m_tail + sizeof(length)) % m_ring.size();
+        const size_t first = std::min<size_t>(length, m_ring.size() - position);
+        WriteFile(file, m_ring.data() + position, first);
+        WriteFile(file, m_ring.data(), length - first);
+        WriteFile(file, "\n", 1);
+
+        DropOldest();
+    }
+    CloseFile(file);
+
+    ClearLogs(m_root, kDumpExtension);
+}
+
+size_t Debug::FlightRecorderSink::GetCapacity() const {
+    return m_ring.size();
+}
+
+size_t Debug::FlightRecorderSink::GetRecordCount() const {
+    return m_records;
+}
+
+void Debug::FlightRecorderSink::Push(const char* data, const size_t size) {
+    const size_t first = std::min(size, m_ring.size() - m_head);
+    std::memcpy(m_ring.data() + m_head, data, first);
+    std::memcpy(m_ring.data(), data + first, size - first);
+
+    m_head = (m_head + size) % m_ring.size();
+    m_used += size;
+}
+
+void Debug::FlightRecorderSink::Copy(const size_t position, char* out, const size_t size) const {
+    const size_t first = std::min(size, m_ring.size() - position);
+    std::memcpy(out, m_ring.data() + position, first);
+    std::memcpy(out + first, m_ring.data(), size - first);
+}
+
+void Debug::FlightRecorderSink::DropOldest() {
+    RecordLength length;
+    Copy(m_tail, reinterpret_cast<char*>(&length), sizeof(length));
+
+    const size_t entry = sizeof(length) + length;
+    m_tail = (m_tail + entry) % m_ring.size();
+    m_used -= entry;
+    m_records--;
+}
+
+void Debug::FlightRecorderSink::FlushFromSignal() noexcept {
+    if (m_records == 0 || m_crashDumpPath.empty()) {
+        return;
+    }
+
+#if !defined(_WIN32)
+    const int file = ::open(m_crashDumpPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (file < 0) {
+        return;
+    }
+
+    // Walks a copy of the read position; the ring itself is left as is.
+    size_t tail = m_tail;
+    for (size_t i = 0; i < m_records; ++i) {
+        RecordLength length;
+        Copy(tail, reinterpret_cast<char*>(&length), sizeof(length));
+
+        const size_t position = (tail + sizeof(length)) % m_ring.size();
+        const size_t first = std::min<size_t>(length, m_ring.size() - position);
+        WriteFile(file, m_ring.data() + position, first);
+        WriteFile(file, m_ring.data(), length - first);
+        WriteFile(file, "\n", 1);
+
+        tail = (tail + sizeof(length) + length) % m_ring.size();
+    }
+    ::close(file);
+#endif
+}
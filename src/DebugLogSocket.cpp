@@ -0,0 +1,244 @@
+#include <DebugLogSocket.h>
+
+#if !defined(_WIN32)
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+Debug::SocketSink::SocketSink(std::filesystem::path socketPath, std::filesystem::path spillDirectory, const LogLevel minLevel)
+    : Sink(minLevel), m_socketPath(std::move(socketPath)), m_spill(std::move(spillDirectory), minLevel),
+      m_spillOpen(false), m_socket(-1), m_stopping(false) { }
+
+Debug::SocketSink::~SocketSink() {
+    StopReconnecting();
+    Disconnect();
+}
+
+void Debug::SocketSink::Open(const Settings& settings) {
+    m_settings = settings;
+
+    // Connect right away so that the first records do not spill needlessly.
+    Connect();
+
+    std::lock_guard<std::mutex> lock(m_reconnectMutex);
+    if (!m_reconnectThread.joinable()) {
+        m_stopping = false;
+        m_reconnectThread = std::thread(&SocketSink::ReconnectLoop, this);
+    }
+}
+
+void Debug::SocketSink::Close() {
+    StopReconnecting();
+    Disconnect();
+
+    if (m_spillOpen) {
+        m_spill.Close();
+        m_spillOpen = false;
+    }
+}
+
+void Debug::SocketSink::Reconfigure(const Settings& settings) {
+    // The connection does not depend on the settings; only the spill does.
+    m_settings = settings;
+    if (m_spillOpen) {
+        m_spill.Reconfigure(settings);
+    }
+}
+
+void Debug::SocketSink::Write(const RecordBatch& records) {
+#if defined(__linux__)
+    mmsghdr messages[MaxBatch];
+#else
+    struct { msghdr msg_hdr; } messages[MaxBatch];
+#endif
+    iovec vectors[MaxBatch];
+
+    size_t sent = 0;
+    while (sent < records.size()) {
+        const int socket = m_socket.load(std::memory_order_acquire);
+        if (socket < 0) {
+            break;
+        }
+
+        // Lines with a context are rendered first; the buffer may move while
+        // it grows, so the vectors only point into it once it is complete.
+        const size_t count = std::min(MaxBatch, records.size() - sent);
+        size_t lineEnds[MaxBatch];
+        m_lines.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (records[sent + i].context) {
+                AppendLine(m_lines, records[sent + i]);
+            }
+            lineEnds[i] = m_lines.size();
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const Record& record = records[sent + i];
+            if (record.context) {
+                const size_t lineStart = i > 0 ? lineEnds[i - 1] : 0;
+                vectors[i].iov_base = m_lines.data() + lineStart;
+                vectors[i].iov_len = lineEnds[i] - lineStart;
+            } else {
+                vectors[i].iov_base = const_cast<char*>(record.text.data());
+                vectors[i].iov_len = record.text.size();
+            }
+            messages[i] = {};
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+#if defined(__linux__)
+        const int result = sendmmsg(socket, messages, static_cast<unsigned>(count), MSG_NOSIGNAL);
+#else
+        const int result = sendmsg(socket, &messages[0].msg_hdr, MSG_NOSIGNAL) < 0 ? -1 : 1;
+#endif
+        if (result > 0) {
+            sent += static_cast<size_t>(result);
+            continue;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EMSGSIZE) {
+            // Too large for a datagram; only this record goes to the file.
+            Spill(records.Slice(sent, 1));
+            sent++;
+            continue;
+        }
+
+        // The peer is gone or has stopped reading within SendTimeout.
+        Disconnect();
+    }
+
+    if (sent < records.size()) {
+        Spill(records.Slice(sent, records.size() - sent));
+    }
+}
+
+void Debug::SocketSink::Flush() {
+    if (m_spillOpen) {
+        m_spill.Flush();
+    }
+}
+
+void Debug::SocketSink::FlushFromSignal() noexcept {
+    m_spill.FlushFromSignal();
+}
+
+void Debug::SocketSink::WriteFromSignal(const LogLevel level, const std::string_view text) noexcept {
+    if (!Accepts(level)) {
+        return;
+    }
+
+    const int socket = m_socket.load(std::memory_order_acquire);
+    if (socket < 0 || send(socket, text.data(), text.size(), MSG_NOSIGNAL) < 0) {
+        m_spill.WriteFromSignal(level, text);
+    }
+}
+
+bool Debug::SocketSink::IsConnected() const {
+    return m_socket.load(std::memory_order_acquire) >= 0;
+}
+
+const std::filesystem::path& Debug::SocketSink::GetSocketPath() const {
+    return m_socketPath;
+}
+
+bool Debug::SocketSink::Connect() {
+    if (IsConnected()) {
+        return true;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    const std::string path = m_socketPath.string();
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int socket = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (socket < 0) {
+        return false;
+    }
+    fcntl(socket, F_SETFD, FD_CLOEXEC);
+
+    timeval timeout{};
+    timeout.tv_usec = static_cast<suseconds_t>(std::chrono::microseconds(SendTimeout).count());
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    if (connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        close(socket);
+        return false;
+    }
+
+    int expected = -1;
+    if (!m_socket.compare_exchange_strong(expected, socket, std::memory_order_acq_rel)) {
+        close(socket);
+    }
+    return true;
+}
+
+void Debug::SocketSink::Disconnect() {
+    const int socket = m_socket.exchange(-1, std::memory_order_acq_rel);
+    if (socket >= 0) {
+        close(socket);
+        m_reconnectCondition.notify_one();
+    }
+}
+
+void Debug::SocketSink::Spill(const RecordBatch& records) {
+    if (!m_spillOpen) {
+        m_spill.Open(m_settings);
+        m_spillOpen = true;
+    }
+
+    m_spill.Write(records);
+}
+
+void Debug::SocketSink::ReconnectLoop() {
+    std::unique_lock<std::mutex> lock(m_reconnectMutex);
+    while (!m_stopping) {
+        m_reconnectCondition.wait_for(lock, ReconnectInterval, [this] {
+            return m_stopping || !IsConnected();
+        });
+        if (m_stopping) {
+            break;
+        }
+
+        if (!IsConnected()) {
+            lock.unlock();
+            Connect();
+            lock.lock();
+
+            // Retry at most once per interval while the peer is missing.
+            m_reconnectCondition.wait_for(lock, ReconnectInterval, [this] { return m_stopping; });
+        }
+    }
+}
+
+void Debug::SocketSink::StopReconnecting() {
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(m_reconnectMutex);
+        m_stopping = true;
+        thread = std::move(m_reconnectThread);
+    }
+
+    m_reconnectCondition.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+#endif // !_WIN32
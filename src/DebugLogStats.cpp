@@ -0,0 +1,131 @@
+#include <DebugLog.h>
+#include <DebugLogSinks.h>
+#include <algorithm>
+
+namespace {
+    constexpr size_t kLevels = 3;
+    constexpr size_t kShards = 16;
+
+    // Counters bumped by producer threads, spread over cache-line sized
+    // shards so that threads logging in parallel do not share a line.
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> records[kLevels];
+        std::atomic<uint64_t> bytes[kLevels];
+        std::atomic<uint64_t> lockWaitNanoseconds;
+        std::atomic<uint64_t> stacktraces;
+        std::atomic<uint64_t> stacktraceNanoseconds;
+    };
+
+    // Counters only bumped under the IO lock.
+    struct IoCounters {
+        std::atomic<uint64_t> flushes;
+        std::atomic<uint64_t> rotations;
+        std::atomic<uint64_t> rotationNanoseconds;
+        std::atomic<uint64_t> droppedRecords;
+        std::atomic<uint64_t> queueHighWaterMark;
+    };
+
+    Shard      shards[kShards];
+    IoCounters ioCounters;
+
+    Shard& LocalShard() {
+        static std::atomic<size_t> nextShard{0};
+        thread_local Shard& shard = shards[nextShard.fetch_add(1, std::memory_order_relaxed) % kShards];
+        return shard;
+    }
+
+    void Add(std::atomic<uint64_t>& counter, const uint64_t value) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t ToNanoseconds(const std::chrono::steady_clock::duration duration) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    double ToMilliseconds(const uint64_t nanoseconds) {
+        return static_cast<double>(nanoseconds) / 1e6;
+    }
+}
+
+std::chrono::steady_clock::time_point Debug::m_statsDeadline{};
+
+Debug::Stats Debug::GetStats() {
+    Stats stats;
+    for (const Shard& shard : shards) {
+        for (size_t level = 0; level < kLevels; ++level) {
+            stats.records[level] += shard.records[level].load(std::memory_order_relaxed);
+            stats.bytes[level] += shard.bytes[level].load(std::memory_order_relaxed);
+        }
+        stats.lockWaitNanoseconds += shard.lockWaitNanoseconds.load(std::memory_order_relaxed);
+        stats.stacktraces += shard.stacktraces.load(std::memory_order_relaxed);
+        stats.stacktraceNanoseconds += shard.stacktraceNanoseconds.load(std::memory_order_relaxed);
+    }
+
+    stats.flushes = ioCounters.flushes.load(std::memory_order_relaxed);
+    stats.rotations = ioCounters.rotations.load(std::memory_order_relaxed);
+    stats.rotationNanoseconds = ioCounters.rotationNanoseconds.load(std::memory_order_relaxed);
+    stats.droppedRecords = ioCounters.droppedRecords.load(std::memory_order_relaxed);
+    stats.queueHighWaterMark = ioCounters.queueHighWaterMark.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void Debug::CountRecord(const LogLevel type, const size_t bytes) {
+    Shard& shard = LocalShard();
+    Add(shard.records[static_cast<size_t>(type)], 1);
+    Add(shard.bytes[static_cast<size_t>(type)], bytes);
+}
+
+void Debug::CountLockWait(const std::chrono::steady_clock::duration wait) {
+    Add(LocalShard().lockWaitNanoseconds, ToNanoseconds(wait));
+}
+
+void Debug::CountStacktrace(const std::chrono::steady_clock::duration duration) {
+    Shard& shard = LocalShard();
+    Add(shard.stacktraces, 1);
+    Add(shard.stacktraceNanoseconds, ToNanoseconds(duration));
+}
+
+void Debug::CountFlush() {
+    Add(ioCounters.flushes, 1);
+}
+
+void Debug::CountRotation(const std::chrono::steady_clock::duration duration) {
+    Add(ioCounters.rotations, 1);
+    Add(ioCounters.rotationNanoseconds, ToNanoseconds(duration));
+}
+
+void Debug::CountDropped(const size_t count) {
+    Add(ioCounters.droppedRecords, count);
+}
+
+void Debug::CountQueueDepth(const size_t depth) {
+    // The queue only grows until the writer takes all of it, so the size of
+    // a drained batch is the peak depth of that cycle.
+    if (depth > ioCounters.queueHighWaterMark.load(std::memory_order_relaxed)) {
+        ioCounters.queueHighWaterMark.store(depth, std::memory_order_relaxed);
+    }
+}
+
+void Debug::LogStatsLocked() {
+    const auto now = std::chrono::steady_clock::now();
+    if (now < m_statsDeadline) {
+        return;
+    }
+    // Moved first: the line below goes through DispatchLocked again.
+    m_statsDeadline = now + std::chrono::seconds(m_settings->statsInterval);
+
+    const Stats stats = GetStats();
+    fmt::memory_buffer message;
+    fmt::format_to(fmt::appender(message),
+                   "Logger stats: records {}/{}/{} (LOG/WARNING/ERROR), {} bytes, lock wait {:.3f} ms, {} flushes, "
+                   "{} rotations in {:.3f} ms, {} dropped, queue high-water {}, {} stacktraces in {:.3f} ms",
+                   stats.records[0], stats.records[1], stats.records[2],
+                   stats.bytes[0] + stats.bytes[1] + stats.bytes[2],
+                   ToMilliseconds(stats.lockWaitNanoseconds), stats.flushes,
+                   stats.rotations, ToMilliseconds(stats.rotationNanoseconds), stats.droppedRecords,
+                   stats.queueHighWaterMark, stats.stacktraces, ToMilliseconds(stats.stacktraceNanoseconds));
+
+    const RecordPtr record = CreateRecord({message.data(), message.size()}, LogLevel::DEFAULT_DEBUG_LOG);
+    const Record* records[] = {record.get()};
+    DispatchLocked(records, 1);
+}
@@ -0,0 +1,125 @@
+#include <DebugLogTrace.h>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    int GetProcessId() {
+#if defined(_WIN32)
+        static const int pid = _getpid();
+#else
+        static const int pid = getpid();
+#endif
+        return pid;
+    }
+
+    void AppendEscaped(fmt::memory_buffer& out, const std::string_view value) {
+        for (const char c : value) {
+            switch (c) {
+                case '"':  out.append(std::string_view("\\\"")); break;
+                case '\\': out.append(std::string_view("\\\\")); break;
+                case '\n': out.append(std::string_view("\\n")); break;
+                case '\r': out.append(std::string_view("\\r")); break;
+                case '\t': out.append(std::string_view("\\t")); break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        fmt::format_to(fmt::appender(out), "\\u{:04x}", static_cast<unsigned>(c));
+                    } else {
+                        out.push_back(c);
+                    }
+            }
+        }
+    }
+}
+
+Debug::TraceSink::TraceSink(std::filesystem::path directory, const LogLevel minLevel)
+    : Sink(minLevel), m_file(std::move(directory), minLevel, ".json", "[\n") { }
+
+void Debug::TraceSink::Open(const Settings& settings) {
+    m_file.Open(settings);
+}
+
+void Debug::TraceSink::Close() {
+    m_file.Close();
+}
+
+void Debug::TraceSink::Reconfigure(const Settings& settings) {
+    m_file.Reconfigure(settings);
+}
+
+void Debug::TraceSink::Write(const RecordBatch& records) {
+    for (const Record& record : records) {
+        if (record.IsSpan()) {
+            // Spans are logged when they end, so the event starts the
+            // measured duration earlier. One complete event per span keeps
+            // a rotation from splitting it across segments.
+            const auto begin = record.time - std::chrono::duration_cast<std::chrono::system_clock::duration>(record.spanDuration);
+            WriteEvent(record, 'X', begin);
+        } else {
+            WriteEvent(record, 'i', record.time);
+        }
+    }
+}
+
+void Debug::TraceSink::Flush() {
+    m_file.Flush();
+}
+
+void Debug::TraceSink::FlushFromSignal() noexcept {
+    m_file.FlushFromSignal();
+}
+
+const std::filesystem::path& Debug::TraceSink::GetDirectory() const {
+    return m_file.GetDirectory();
+}
+
+void Debug::TraceSink::WriteEvent(const Record& record, const char phase, const std::chrono::system_clock::time_point time) {
+    // Timestamps are microseconds; printed from integer nanoseconds, since a
+    // double cannot hold microseconds since the epoch to three decimals.
+    const int64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+
+    m_event.clear();
+    m_event.append(std::string_view("{\"name\":\""));
+    AppendEscaped(m_event, record.IsSpan() ? record.spanName : record.message);
+    fmt::format_to(fmt::appender(m_event), "\",\"ph\":\"{}\",\"ts\":{}.{:03},\"pid\":{},\"tid\":{}",
+                   phase, nanoseconds / 1000, nanoseconds % 1000, GetProcessId(), record.thread);
+    if (phase == 'X') {
+        const int64_t duration = record.spanDuration.count();
+        fmt::format_to(fmt::appender(m_event), ",\"dur\":{}.{:03}", duration / 1000, duration % 1000);
+    } else {
+        m_event.append(std::string_view(",\"s\":\"t\""));
+    }
+    m_event.append(std::string_view(",\"args\":{\"level\":\""));
+    m_event.append(std::string_view(LogTypeToString(record.level)));
+    if (phase == 'i') {
+        m_event.append(std::string_view("\",\"message\":\""));
+        AppendEscaped(m_event, record.message);
+    }
+    m_event.push_back('"');
+    if (record.location.IsKnown()) {
+        m_event.append(std::string_view(",\"file\":\""));
+        AppendEscaped(m_event, record.location.file);
+        fmt::format_to(fmt::appender(m_event), "\",\"line\":{}", record.location.line);
+    }
+    // Nested, so that a field named like one of the keys above cannot
+    // repeat it.
+    if (record.context) {
+        m_event.append(std::string_view(",\"context\":{"));
+        bool first = true;
+        for (const Context::Field& field : record.context->fields) {
+            m_event.append(std::string_view(first ? "\"" : ",\""));
+            AppendEscaped(m_event, field.key);
+            m_event.append(std::string_view("\":\""));
+            AppendEscaped(m_event, field.value);
+            m_event.push_back('"');
+            first = false;
+        }
+        m_event.push_back('}');
+    }
+    m_event.append(std::string_view("}},"));
+
+    m_file.WriteLine(time, {m_event.data(), m_event.size()});
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <DebugLog.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::atomic<size_t> g_allocationCount{0};
+    thread_local bool g_countAllocations = false;
+}
+
+// Replacing the global allocation functions lets the test observe every heap
+// allocation made by the calling thread while counting is enabled.
+void* operator new(const std::size_t size) {
+    if (g_countAllocations) {
+        g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+class DebugLogAllocationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (fs::exists("logs")) {
+            fs::remove_all("logs");
+        }
+    }
+
+    void TearDown() override {
+        g_countAllocations = false;
+        Debug::SetSettings({});
+        Debug::Shutdown();
+
+        if (fs::exists("logs")) {
+            fs::remove_all("logs");
+        }
+    }
+
+    template <typename F>
+    static size_t CountAllocations(F&& body) {
+        g_allocationCount.store(0);
+        g_countAllocations = true;
+        body();
+        g_countAllocations = false;
+        return g_allocationCount.load();
+    }
+};
+
+TEST_F(DebugLogAllocationTest, SteadyStateLogDoesNotAllocate) {
+    const std::string message = "Steady state std::string message";
+
+    // Warm up: opens the log files and grows the per-thread buffers.
+    Debug::Log("Warm up message");
+    Debug::Log(message);
+    Debug::Log(42);
+    Debug::Log("Warm up value: {} {}", 42, message);
+
+    const size_t allocations = CountAllocations([&]() {
+        for (int i = 0; i < 100; ++i) {
+            Debug::Log("Steady state message");
+            Debug::Log(message);
+            Debug::Log(i);
+            Debug::Log("Steady state value: {} {}", i, message);
+        }
+    });
+
+    EXPECT_EQ(allocations, 0u);
+}
+
+TEST_F(DebugLogAllocationTest, InvalidUtf8DoesNotAllocateInSteadyState) {
+    const std::string invalid = "Invalid \xFF\xFE sequence";
+
+    Debug::Log(invalid);
+
+    const size_t allocations = CountAllocations([&]() {
+        for (int i = 0; i < 100; ++i) {
+            Debug::Log(invalid);
+        }
+    });
+
+    EXPECT_EQ(allocations, 0u);
+}
+
+TEST_F(DebugLogAllocationTest, AsynchronousProducerDoesNotAllocate) {
+    Debug::Settings settings{"", 1024 * 1024, 5, 3600};
+    settings.asynchronous = true;
+    Debug::SetSettings(settings);
+
+    Debug::Log("Warm up message");
+    Debug::Log("Warm up value: {}", 42);
+
+    const size_t allocations = CountAllocations([&]() {
+        for (int i = 0; i < 1000; ++i) {
+            Debug::Log("Queued message");
+            Debug::Log("Queued value: {}", i);
+        }
+    });
+
+    EXPECT_EQ(allocations, 0u);
+}
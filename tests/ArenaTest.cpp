@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <DebugLogArena.h>
+
+TEST(DebugLogArenaTest, RecyclesSlabsOnceAllBlocksAreReleased) {
+    Debug::RecordArena arena(1024 * 1024);
+
+    size_t firstRoundReserved = 0;
+    for (int round = 0; round < 10; ++round) {
+        std::vector<void*> blocks;
+        for (int i = 0; i < 2000; ++i) {
+            void* block = arena.Allocate(100);
+            ASSERT_NE(block, nullptr);
+            blocks.push_back(block);
+        }
+
+        if (round == 0) {
+            firstRoundReserved = arena.GetReservedBytes();
+        }
+
+        // The slab the thread is still filling stays out of the pool, so a
+        // later round may need at most one slab more than the first.
+        EXPECT_LE(arena.GetReservedBytes(), firstRoundReserved + 2 * Debug::RecordArena::SlabSize)
+            << "Released slabs should be reused, not reallocated";
+
+        for (void* block : blocks) {
+            Debug::RecordArena::Release(block);
+        }
+    }
+}
+
+TEST(DebugLogArenaTest, NeverExceedsMemoryLimit) {
+    constexpr size_t kLimit = 4 * Debug::RecordArena::SlabSize;
+    Debug::RecordArena arena(kLimit);
+
+    std::vector<void*> blocks;
+    while (void* block = arena.Allocate(1000)) {
+        blocks.push_back(block);
+        ASSERT_LE(arena.GetReservedBytes(), kLimit);
+    }
+
+    EXPECT_FALSE(blocks.empty());
+    EXPECT_EQ(arena.Allocate(1000), nullptr);
+
+    for (void* block : blocks) {
+        Debug::RecordArena::Release(block);
+    }
+
+    void* block = arena.Allocate(1000);
+    EXPECT_NE(block, nullptr) << "Memory should be available again after the consumer released it";
+    Debug::RecordArena::Release(block);
+}
+
+TEST(DebugLogArenaTest, OversizedBlocksCountAgainstLimit) {
+    constexpr size_t kLimit = 8 * Debug::RecordArena::SlabSize;
+    Debug::RecordArena arena(kLimit);
+
+    void* block = arena.Allocate(3 * Debug::RecordArena::SlabSize);
+    ASSERT_NE(block, nullptr);
+    EXPECT_GT(arena.GetReservedBytes(), 3 * Debug::RecordArena::SlabSize);
+
+    EXPECT_EQ(arena.Allocate(6 * Debug::RecordArena::SlabSize), nullptr);
+
+    Debug::RecordArena::Release(block);
+    EXPECT_EQ(arena.GetReservedBytes(), 0u) << "Oversized slabs are freed, not pooled";
+}
+
+TEST(DebugLogArenaTest, ConsumerThreadReleasesProducerBlocks) {
+    Debug::RecordArena arena(1024 * 1024);
+
+    std::vector<void*> blocks;
+    std::thread producer([&]() {
+        for (int i = 0; i < 1000; ++i) {
+            blocks.push_back(arena.Allocate(200));
+        }
+    });
+    producer.join();
+
+    for (void* block : blocks) {
+        ASSERT_NE(block, nullptr);
+        Debug::RecordArena::Release(block);
+    }
+
+    // The producer has exited, so every slab is back in the pool and can be
+    // handed to a new thread without growing the arena.
+    const size_t reserved = arena.GetReservedBytes();
+    void* block = arena.Allocate(200);
+    EXPECT_NE(block, nullptr);
+    EXPECT_EQ(arena.GetReservedBytes(), reserved);
+    Debug::RecordArena::Release(block);
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <DebugLogConfig.h>
+
+namespace fs = std::filesystem;
+
+class DebugLogConfigTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Cleanup();
+        fs::create_directories("config");
+    }
+
+    void TearDown() override {
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        Cleanup();
+    }
+
+    static void Cleanup() {
+        if (fs::exists("logs")) fs::remove_all("logs");
+        if (fs::exists("config")) fs::remove_all("config");
+    }
+
+    static void WriteConfig(const fs::path& path, const std::string& content) {
+        // Written next to the file and renamed, the way editors save.
+        const fs::path temporary = fs::path(path).concat(".tmp");
+        {
+            std::ofstream out(temporary);
+            out << content;
+        }
+        fs::rename(temporary, path);
+    }
+
+    static bool WaitForReloads(const Debug::ConfigWatcher& watcher, const uint64_t count) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (watcher.GetReloadCount() < count) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+};
+
+TEST_F(DebugLogConfigTest, ParsesEveryField) {
+    std::istringstream input(
+        "# comment\n"
+        "\n"
+        "rootPath = custom\n"
+        "maxFileSize=1024\n"
+        "maxLogFilesAmount = 3\r\n"
+        "deleteLogsAfter = 60\n"
+        "asynchronous = true\n"
+        "asyncMemoryLimit = 4096\n"
+        "flushOnEveryWrite = false\n"
+        "rotationPolicy = SIZE_OR_DAILY_ROTATION\n"
+        "indexInterval = 65536\n"
+        "statsInterval = 10\n"
+        "sourceLocation = true\n"
+        "minLevel = WARNING_DEBUG_LOG\n"
+        "pattern = %l: %v\n");
+
+    const Debug::Settings settings = Debug::ConfigWatcher::Parse(input, {});
+    EXPECT_EQ(settings.rootPath, fs::path("custom"));
+    EXPECT_EQ(settings.maxFileSize, 1024u);
+    EXPECT_EQ(settings.maxLogFilesAmount, 3u);
+    EXPECT_EQ(settings.deleteLogsAfter, 60u);
+    EXPECT_TRUE(settings.asynchronous);
+    EXPECT_EQ(settings.asyncMemoryLimit, 4096u);
+    EXPECT_FALSE(settings.flushOnEveryWrite);
+    EXPECT_EQ(settings.rotationPolicy, Debug::RotationPolicy::SIZE_OR_DAILY_ROTATION);
+    EXPECT_EQ(settings.indexInterval, 65536u);
+    EXPECT_EQ(settings.statsInterval, 10u);
+    EXPECT_TRUE(settings.sourceLocation);
+    EXPECT_EQ(settings.minLevel, Debug::LogLevel::WARNING_DEBUG_LOG);
+    EXPECT_EQ(settings.pattern, "%l: %v");
+}
+
+TEST_F(DebugLogConfigTest, MissingFieldsKeepTheBase) {
+    Debug::Settings base;
+    base.maxLogFilesAmount = 42;
+    std::istringstream input("minLevel = ERROR_DEBUG_LOG\n");
+
+    const Debug::Settings settings = Debug::ConfigWatcher::Parse(input, base);
+    EXPECT_EQ(settings.maxLogFilesAmount, 42u);
+    EXPECT_EQ(settings.minLevel, Debug::LogLevel::ERROR_DEBUG_LOG);
+}
+
+TEST_F(DebugLogConfigTest, RejectsInvalidLines) {
+    const char* const invalid[] = {
+        "unknown = 1\n",
+        "maxFileSize = -1\n",
+        "maxFileSize = 12kb\n",
+        "asynchronous = yes\n",
+        "minLevel = DEBUG\n",
+        "rotationPolicy = WEEKLY\n",
+        "# fine\nno separator\n",
+    };
+    for (const char* text : invalid) {
+        std::istringstream input(text);
+        EXPECT_THROW((void)Debug::ConfigWatcher::Parse(input, {}), std::runtime_error) << text;
+    }
+
+    std::istringstream input("\nminLevel = LOUD\n");
+    try {
+        (void)Debug::ConfigWatcher::Parse(input, {});
+        FAIL();
+    } catch (const std::runtime_error& exception) {
+        EXPECT_EQ(std::string(exception.what()), "line 2: 'LOUD' is not a log level");
+    }
+}
+
+TEST_F(DebugLogConfigTest, AppliesTheFileWhenItChanges) {
+    const fs::path path = "config/debuglog.conf";
+    WriteConfig(path, "minLevel = WARNING_DEBUG_LOG\n");
+
+    Debug::ConfigWatcher watcher(path, std::chrono::milliseconds(10));
+    EXPECT_EQ(watcher.GetReloadCount(), 1u);
+    EXPECT_EQ(Debug::GetSettings()->minLevel, Debug::LogLevel::WARNING_DEBUG_LOG);
+    EXPECT_FALSE(Debug::IsEnabled(Debug::LogLevel::DEFAULT_DEBUG_LOG));
+
+    WriteConfig(path, "minLevel = ERROR_DEBUG_LOG\nmaxLogFilesAmount = 4\n");
+    ASSERT_TRUE(WaitForReloads(watcher, 2));
+    EXPECT_EQ(Debug::GetSettings()->minLevel, Debug::LogLevel::ERROR_DEBUG_LOG);
+    EXPECT_EQ(Debug::GetSettings()->maxLogFilesAmount, 4u);
+
+    // Removing a field restores the value the watcher started with.
+    WriteConfig(path, "maxLogFilesAmount = 4\n");
+    ASSERT_TRUE(WaitForReloads(watcher, 3));
+    EXPECT_EQ(Debug::GetSettings()->minLevel, Debug::LogLevel::DEFAULT_DEBUG_LOG);
+}
+
+TEST_F(DebugLogConfigTest, InvalidFileChangesNothing) {
+    const fs::path path = "config/debuglog.conf";
+    WriteConfig(path, "maxLogFilesAmount = 7\n");
+    Debug::ConfigWatcher watcher(path, std::chrono::milliseconds(10));
+    ASSERT_EQ(Debug::GetSettings()->maxLogFilesAmount, 7u);
+
+    WriteConfig(path, "maxLogFilesAmount = many\n");
+    WriteConfig(path.string() + ".other", "unrelated");
+    WriteConfig(path, "maxLogFilesAmount = 8\n");
+    ASSERT_TRUE(WaitForReloads(watcher, 2));
+    EXPECT_EQ(Debug::GetSettings()->maxLogFilesAmount, 8u);
+}
+
+TEST_F(DebugLogConfigTest, WaitsForAMissingFile) {
+    const fs::path path = "config/later.conf";
+    Debug::ConfigWatcher watcher(path, std::chrono::milliseconds(10));
+    EXPECT_EQ(watcher.GetReloadCount(), 0u);
+
+    WriteConfig(path, "maxLogFilesAmount = 5\n");
+    ASSERT_TRUE(WaitForReloads(watcher, 1));
+    EXPECT_EQ(Debug::GetSettings()->maxLogFilesAmount, 5u);
+}
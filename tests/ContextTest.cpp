@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include <DebugLogSinks.h>
+#include "TestSinks.h"
+
+namespace fs = std::filesystem;
+
+class DebugLogContextTest : public RetainingSinkTest {};
+
+TEST_F(DebugLogContextTest, NestedScopesShareOneRenderedContext) {
+    Debug::Log("Before");
+    {
+        Debug::ScopedContext request{{"request", 42}, {"tenant", "acme"}};
+        Debug::Log("First");
+        {
+            Debug::ScopedContext step{{"step", std::string("parse")}};
+            Debug::Log("Nested");
+        }
+        Debug::Log("Second");
+    }
+    Debug::Log("After");
+
+    ASSERT_EQ(m_sink->retained.size(), 5u);
+    EXPECT_EQ(m_sink->retained[0]->context, nullptr);
+    ASSERT_NE(m_sink->retained[1]->context, nullptr);
+    EXPECT_EQ(m_sink->retained[1]->context->text, "request=42 tenant=acme");
+    EXPECT_EQ(m_sink->retained[2]->context->text, "request=42 tenant=acme step=parse");
+    ASSERT_EQ(m_sink->retained[2]->context->fields.size(), 3u);
+    EXPECT_EQ(m_sink->retained[2]->context->fields[2].key, "step");
+    EXPECT_EQ(m_sink->retained[3]->context, m_sink->retained[1]->context);
+    EXPECT_EQ(m_sink->retained[4]->context, nullptr);
+
+    // Sinks render the context; the record's own text is left alone.
+    EXPECT_EQ(m_sink->retained[1]->message, "First");
+}
+
+TEST_F(DebugLogContextTest, ContextIsPerThread) {
+    Debug::ScopedContext outer{{"thread", "main"}};
+    std::thread([] {
+        Debug::Log("Other thread");
+    }).join();
+    Debug::Log("Main thread");
+
+    ASSERT_EQ(m_sink->retained.size(), 2u);
+    EXPECT_EQ(m_sink->retained[0]->context, nullptr);
+    ASSERT_NE(m_sink->retained[1]->context, nullptr);
+    EXPECT_EQ(m_sink->retained[1]->context->text, "thread=main");
+}
+
+TEST_F(DebugLogContextTest, DeferredRecordsKeepTheirContext) {
+    Debug::Settings settings;
+    settings.asynchronous = true;
+    Debug::SetSettings(settings);
+
+    for (int i = 0; i < 10; ++i) {
+        Debug::ScopedContext context{{"iteration", i}};
+        DEBUG_LOG("Packed {}", i);
+        Debug::Span span("work");
+    }
+    Debug::Shutdown();
+
+    ASSERT_EQ(m_sink->retained.size(), 20u);
+    for (size_t i = 0; i < m_sink->retained.size(); ++i) {
+        ASSERT_NE(m_sink->retained[i]->context, nullptr);
+        EXPECT_EQ(m_sink->retained[i]->context->text, "iteration=" + std::to_string(i / 2));
+    }
+}
+
+TEST_F(DebugLogContextTest, FileSinksRenderContextBeforeTheMessage) {
+    {
+        Debug::ScopedContext context{{"request", 7}};
+        Debug::Log("With context");
+    }
+    Debug::Log("Without context");
+    Debug::Shutdown();
+
+    const std::string content = ReadDirectory("logs/all");
+    EXPECT_NE(content.find("] [request=7] With context\n"), std::string::npos);
+    EXPECT_NE(content.find("] Without context\n"), std::string::npos);
+}
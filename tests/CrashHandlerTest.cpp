@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <DebugLogSinks.h>
+
+#if !defined(_WIN32)
+#include <csignal>
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define DEBUG_LOG_SANITIZER_SIGNALS
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#define DEBUG_LOG_SANITIZER_SIGNALS
+#endif
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::string ReadDirectory(const fs::path& directory) {
+        std::string content;
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            std::ifstream in(entry.path());
+            content.append((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        }
+        return content;
+    }
+
+    volatile bool recurse = true;
+
+    // Recurses until the thread's stack runs out.
+    int Overflow(const int depth) {
+        volatile char frame[1024];
+        frame[0] = static_cast<char>(depth);
+        return recurse ? Overflow(depth + 1) + frame[0] : frame[0];
+    }
+}
+
+class DebugLogCrashHandlerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+#ifdef DEBUG_LOG_SANITIZER_SIGNALS
+        GTEST_SKIP() << "Sanitizers handle fatal signals themselves";
+#endif
+        GTEST_FLAG_SET(death_test_style, "threadsafe");
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    void TearDown() override {
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+};
+
+TEST_F(DebugLogCrashHandlerTest, BufferedRecordsSurviveFatalSignal) {
+    EXPECT_EXIT({
+        Debug::Settings settings{};
+        settings.flushOnEveryWrite = false;
+        Debug::SetSettings(settings);
+        Debug::InstallCrashHandler();
+
+        Debug::Log("Buffered before the crash");
+        std::raise(SIGSEGV);
+    }, ::testing::KilledBySignal(SIGSEGV), "");
+
+    const std::string content = ReadDirectory("logs/all");
+    EXPECT_NE(content.find("Buffered before the crash"), std::string::npos);
+    EXPECT_NE(content.find("Fatal signal 11 (SIGSEGV)"), std::string::npos);
+    EXPECT_LT(content.find("Buffered before the crash"), content.find("Fatal signal"));
+    EXPECT_NE(content.find(" 0# 0x"), std::string::npos);
+}
+
+TEST_F(DebugLogCrashHandlerTest, QueuedRecordsSurviveAbort) {
+    EXPECT_EXIT({
+        Debug::Settings settings{};
+        settings.flushOnEveryWrite = false;
+        settings.asynchronous = true;
+        Debug::SetSettings(settings);
+        Debug::InstallCrashHandler();
+
+        for (int i = 0; i < 100; ++i) {
+            Debug::Log("Queued {}", i);
+        }
+        std::abort();
+    }, ::testing::KilledBySignal(SIGABRT), "");
+
+    const std::string content = ReadDirectory("logs/all");
+    EXPECT_NE(content.find("Queued 0"), std::string::npos);
+    EXPECT_NE(content.find("Queued 99"), std::string::npos);
+    EXPECT_NE(content.find("(SIGABRT)"), std::string::npos);
+}
+
+TEST_F(DebugLogCrashHandlerTest, QueuedRecordsKeepTheirContext) {
+    EXPECT_EXIT({
+        Debug::Settings settings{};
+        settings.flushOnEveryWrite = false;
+        settings.asynchronous = true;
+        Debug::SetSettings(settings);
+        Debug::InstallCrashHandler();
+
+        Debug::ScopedContext context({{"request", 42}});
+        for (int i = 0; i < 100; ++i) {
+            Debug::Log("Queued {}", i);
+        }
+        std::abort();
+    }, ::testing::KilledBySignal(SIGABRT), "");
+
+    const std::string content = ReadDirectory("logs/all");
+    EXPECT_NE(content.find("[request=42] Queued 0"), std::string::npos);
+    EXPECT_NE(content.find("[request=42] Queued 99"), std::string::npos);
+    EXPECT_EQ(content.find("] Queued"), content.find("[request=42] Queued") + 11);
+}
+
+TEST_F(DebugLogCrashHandlerTest, StackOverflowOnLoggingThreadIsHandled) {
+    EXPECT_EXIT({
+        Debug::SetSettings({});
+        Debug::InstallCrashHandler();
+
+        std::thread([] {
+            Debug::Log("Logged before the overflow");
+            Overflow(0);
+        }).join();
+    }, ::testing::KilledBySignal(SIGSEGV), "");
+
+    const std::string content = ReadDirectory("logs/all");
+    EXPECT_NE(content.find("Logged before the overflow"), std::string::npos);
+    EXPECT_NE(content.find("Fatal signal 11 (SIGSEGV)"), std::string::npos);
+}
+
+TEST_F(DebugLogCrashHandlerTest, SinksAddedAfterInstallAreFlushed) {
+    EXPECT_EXIT({
+        Debug::Settings settings{};
+        settings.flushOnEveryWrite = false;
+        Debug::SetSettings(settings);
+        Debug::InstallCrashHandler();
+        Debug::AddSink(std::make_shared<Debug::FileSink>("logs/late"));
+
+        Debug::Log("Buffered in a late sink");
+        std::raise(SIGSEGV);
+    }, ::testing::KilledBySignal(SIGSEGV), "");
+
+    const std::string content = ReadDirectory("logs/late");
+    EXPECT_NE(content.find("Buffered in a late sink"), std::string::npos);
+    EXPECT_NE(content.find("Fatal signal 11 (SIGSEGV)"), std::string::npos);
+}
+#endif // !_WIN32
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include <DebugLogSinks.h>
+#include "TestSinks.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    // Holds written records back until Flush, like a buffered file.
+    class BufferingSink final : public Debug::Sink {
+    public:
+        void Write(const Debug::RecordBatch& records) override {
+            for (const Debug::Record& record : records) {
+                pending.emplace_back(record.message);
+            }
+        }
+
+        void Flush() override {
+            for (std::string& message : pending) {
+                flushed.push_back(std::move(message));
+            }
+            pending.clear();
+            flushedCount.store(flushed.size(), std::memory_order_release);
+        }
+
+        std::vector<std::string> pending;
+        std::vector<std::string> flushed;
+        std::atomic<size_t>      flushedCount{0};
+    };
+
+#if defined(__cpp_impl_coroutine)
+    struct FireAndForget_ {
+        struct promise_type {
+            FireAndForget_ get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() { }
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    FireAndForget_ LogAndFlush(const BufferingSink& sink, size_t& seen, std::thread::id& resumedOn, std::atomic<bool>& done) {
+        Debug::Log("From a coroutine");
+        co_await Debug::FlushAsync();
+        seen = sink.flushedCount.load(std::memory_order_acquire);
+        resumedOn = std::this_thread::get_id();
+        done.store(true, std::memory_order_release);
+    }
+
+    FireAndForget_ FlushAndShutdown(std::atomic<bool>& done) {
+        Debug::Log("Before shutdown");
+        co_await Debug::FlushAsync();
+        Debug::Shutdown();
+        done.store(true, std::memory_order_release);
+    }
+
+    FireAndForget_ ShutDownAndDestroy(std::shared_ptr<RetainingSink> sink, std::thread::id& resumedOn,
+                                      std::vector<std::thread::id>& writerThreads, std::atomic<bool>& done) {
+        Debug::Log("Before shutdown");
+        co_await Debug::FlushAsync();
+        resumedOn = std::this_thread::get_id();
+
+        Debug::Shutdown();
+        Debug::RemoveSink(sink);
+        writerThreads = sink->writerThreads;
+        sink.reset();
+        done.store(true, std::memory_order_release);
+    }
+#endif
+}
+
+class DebugLogFlushTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (fs::exists("logs")) fs::remove_all("logs");
+        m_sink = std::make_shared<BufferingSink>();
+        Debug::AddSink(m_sink);
+    }
+
+    void TearDown() override {
+        Debug::RemoveSink(m_sink);
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    static void SetAsynchronous(const bool asynchronous) {
+        Debug::Settings settings;
+        settings.asynchronous = asynchronous;
+        settings.flushOnEveryWrite = false;
+        Debug::SetSettings(settings);
+    }
+
+    std::shared_ptr<BufferingSink> m_sink;
+};
+
+TEST_F(DebugLogFlushTest, FlushesBufferedRecordsInSynchronousMode) {
+    SetAsynchronous(false);
+    Debug::Log("Buffered");
+    EXPECT_EQ(m_sink->flushedCount.load(), 0u);
+
+    Debug::Flush();
+    ASSERT_EQ(m_sink->flushed.size(), 1u);
+    EXPECT_EQ(m_sink->flushed[0], "Buffered");
+}
+
+TEST_F(DebugLogFlushTest, WaitsForTheWriterInAsynchronousMode) {
+    SetAsynchronous(true);
+
+    constexpr int kThreads = 4;
+    constexpr int kMessagesPerThread = 500;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < kMessagesPerThread; ++i) {
+                Debug::Log("Message {}", i);
+            }
+            // Each thread only waits for its own records.
+            Debug::Flush();
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(m_sink->flushedCount.load(), static_cast<size_t>(kThreads * kMessagesPerThread));
+}
+
+TEST_F(DebugLogFlushTest, ConcurrentFlushesAllReturn) {
+    SetAsynchronous(true);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 50; ++i) {
+                Debug::Log("Flushing {}", i);
+                Debug::Flush();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(m_sink->flushedCount.load(), 400u);
+}
+
+#if defined(__cpp_impl_coroutine)
+TEST_F(DebugLogFlushTest, CoroutineResumesAfterTheFlush) {
+    SetAsynchronous(true);
+
+    size_t seen = 0;
+    std::thread::id resumedOn;
+    std::atomic<bool> done{false};
+    LogAndFlush(*m_sink, seen, resumedOn, done);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(done.load(std::memory_order_acquire));
+    EXPECT_EQ(seen, 1u);
+    EXPECT_NE(resumedOn, std::this_thread::get_id());
+}
+
+TEST_F(DebugLogFlushTest, CoroutineCanShutDownAfterTheFlush) {
+    SetAsynchronous(true);
+
+    std::atomic<bool> done{false};
+    FlushAndShutdown(done);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(done.load(std::memory_order_acquire));
+    EXPECT_EQ(m_sink->flushedCount.load(), 1u);
+
+    // The logger works again after the shutdown.
+    SetAsynchronous(true);
+    Debug::Log("After shutdown");
+    Debug::Flush();
+    EXPECT_EQ(m_sink->flushedCount.load(), 2u);
+}
+
+TEST_F(DebugLogFlushTest, SinksCanBeDestroyedRightAfterACoroutineShutsDown) {
+    SetAsynchronous(true);
+    auto sink = std::make_shared<RetainingSink>();
+    Debug::AddSink(sink);
+    const std::weak_ptr<RetainingSink> watched = sink;
+
+    std::thread::id resumedOn;
+    std::vector<std::thread::id> writerThreads;
+    std::atomic<bool> done{false};
+    ShutDownAndDestroy(std::move(sink), resumedOn, writerThreads, done);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(done.load(std::memory_order_acquire));
+    EXPECT_TRUE(watched.expired());
+
+    // The writer was joined before the sink went away; it never ran the coroutine.
+    ASSERT_EQ(writerThreads.size(), 1u);
+    EXPECT_NE(writerThreads[0], resumedOn);
+}
+
+TEST_F(DebugLogFlushTest, CoroutineDoesNotSuspendWithoutAWriter) {
+    SetAsynchronous(false);
+
+    size_t seen = 0;
+    std::thread::id resumedOn;
+    std::atomic<bool> done{false};
+    LogAndFlush(*m_sink, seen, resumedOn, done);
+
+    EXPECT_TRUE(done.load());
+    EXPECT_EQ(seen, 1u);
+    EXPECT_EQ(resumedOn, std::this_thread::get_id());
+}
+#endif
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#include <DebugLogIndex.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::string RenderLine(const std::chrono::system_clock::time_point time, const int number) {
+        const std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+        std::tm tm{};
+#if defined(_WIN32)
+        localtime_s(&tm, &seconds);
+#else
+        localtime_r(&seconds, &tm);
+#endif
+        char timestamp[32];
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d_%H-%M-%S", &tm);
+        return fmt::format("[LOG     {}] Indexed record number {:04}", timestamp, number);
+    }
+
+    size_t CountFiles(const fs::path& directory, const std::string& extension) {
+        size_t count = 0;
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            count += entry.path().extension() == extension;
+        }
+        return count;
+    }
+}
+
+class DebugLogIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (fs::exists("logs")) fs::remove_all("logs");
+
+        m_base = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()) - std::chrono::hours(1);
+    }
+
+    void TearDown() override {
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    static Debug::Settings IndexedSettings() {
+        Debug::Settings settings;
+        settings.rootPath = "";
+        settings.indexInterval = 1024;
+        return settings;
+    }
+
+    void WriteRecords(const int count) const {
+        for (int i = 0; i < count; ++i) {
+            const auto time = m_base + std::chrono::seconds(i);
+            Debug::Forward(Debug::LogLevel::DEFAULT_DEBUG_LOG, time, RenderLine(time, i));
+        }
+        Debug::Shutdown();
+    }
+
+    std::chrono::system_clock::time_point m_base;
+};
+
+TEST_F(DebugLogIndexTest, SeeksPastOlderRecords) {
+    Debug::SetSettings(IndexedSettings());
+    WriteRecords(1000);
+
+    const std::vector<fs::path> segments = Debug::LogIndex::ListSegments("logs/all");
+    ASSERT_EQ(segments.size(), 1u);
+    EXPECT_GT(Debug::LogIndex::Load(segments[0]).size(), 10u);
+
+    const uint64_t offset = Debug::LogIndex::FindOffset(segments[0], m_base + std::chrono::seconds(500));
+    EXPECT_GT(offset, 0u);
+    EXPECT_LT(offset, fs::file_size(segments[0]) / 2 + 1);
+    EXPECT_EQ(Debug::LogIndex::FindOffset(segments[0], m_base), 0u);
+}
+
+TEST_F(DebugLogIndexTest, ReadsExactlyTheRequestedRange) {
+    Debug::Settings settings = IndexedSettings();
+    settings.maxFileSize = 8 * 1024;
+    Debug::SetSettings(settings);
+    WriteRecords(1000);
+    ASSERT_GT(Debug::LogIndex::ListSegments("logs/all").size(), 3u);
+
+    std::vector<std::string> records;
+    const size_t count = Debug::LogIndex::ReadRange("logs/all", m_base + std::chrono::seconds(300), m_base + std::chrono::seconds(399),
+                                                    [&records](const std::string_view record) {
+                                                        records.emplace_back(record);
+                                                    });
+
+    ASSERT_EQ(count, 100u);
+    ASSERT_EQ(records.size(), 100u);
+    for (size_t i = 0; i < records.size(); ++i) {
+        EXPECT_EQ(records[i], RenderLine(m_base + std::chrono::seconds(300 + i), static_cast<int>(300 + i)));
+    }
+}
+
+TEST_F(DebugLogIndexTest, MultiLineRecordsStayTogether) {
+    Debug::SetSettings(IndexedSettings());
+    const auto time = m_base + std::chrono::seconds(5);
+    Debug::Forward(Debug::LogLevel::ERROR_DEBUG_LOG, m_base, RenderLine(m_base, 0));
+    Debug::Forward(Debug::LogLevel::ERROR_DEBUG_LOG, time, RenderLine(time, 1) + "\nStacktrace ( \n 0# frame\n)");
+    Debug::Shutdown();
+
+    std::vector<std::string> records;
+    Debug::LogIndex::ReadRange("logs/errors", time, time, [&records](const std::string_view record) {
+        records.emplace_back(record);
+    });
+
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0], RenderLine(time, 1) + "\nStacktrace ( \n 0# frame\n)");
+}
+
+TEST_F(DebugLogIndexTest, RetentionRemovesIndexes) {
+    Debug::Settings settings = IndexedSettings();
+    settings.maxFileSize = 1024;
+    settings.maxLogFilesAmount = 3;
+    Debug::SetSettings(settings);
+    WriteRecords(200);
+
+    EXPECT_EQ(CountFiles("logs/all", ".log"), 3u);
+    EXPECT_EQ(CountFiles("logs/all", ".idx"), 3u);
+}
+
+TEST_F(DebugLogIndexTest, CollectsErrorsOnlyWhenSearchedOnTheirOwn) {
+    Debug::SetSettings({});
+    Debug::Log("Plain");
+    Debug::LogWarning("Repeated in logs/errors");
+    Debug::Shutdown();
+
+    const std::vector<fs::path> tree = Debug::LogIndex::CollectSegments("logs");
+    ASSERT_FALSE(tree.empty());
+    for (const fs::path& segment : tree) {
+        EXPECT_EQ(segment.parent_path().filename(), "all");
+    }
+
+    const std::vector<fs::path> errors = Debug::LogIndex::CollectSegments("logs/errors");
+    ASSERT_EQ(errors.size(), 1u);
+    EXPECT_EQ(errors[0].parent_path().filename(), "errors");
+}
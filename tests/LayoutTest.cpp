@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <DebugLogSinks.h>
+#include "TestSinks.h"
+
+namespace fs = std::filesystem;
+
+class DebugLogLayoutTest : public RetainingSinkTest {
+protected:
+    static void SetPattern(const std::string& pattern, const bool asynchronous = false) {
+        Debug::Settings settings;
+        settings.pattern = pattern;
+        settings.asynchronous = asynchronous;
+        Debug::SetSettings(settings);
+    }
+};
+
+TEST_F(DebugLogLayoutTest, DefaultPatternKeepsTheClassicPrefix) {
+    Debug::Log("Classic");
+
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    const Debug::Record& record = *m_sink->retained[0];
+    EXPECT_EQ(record.text.rfind("[LOG     ", 0), 0u);
+    EXPECT_EQ(record.text.substr(28), "] Classic");
+    EXPECT_EQ(record.message, "Classic");
+}
+
+TEST_F(DebugLogLayoutTest, RendersEveryFlag) {
+    SetPattern("%t [%l] %T %s:%# %! %v (100%%)");
+    const uint32_t line = __LINE__ + 1;
+    DEBUG_LOG_WARNING("Flagged {}", 1);
+
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    const Debug::Record& record = *m_sink->retained[0];
+    const std::string expectedStart = std::to_string(record.thread) + " [WARNING] ";
+    EXPECT_EQ(record.text.rfind(expectedStart, 0), 0u);
+    const std::string expectedLocation = ":" + std::to_string(line) + " TestBody Flagged 1 (100%)";
+    EXPECT_NE(record.text.find("LayoutTest.cpp" + expectedLocation), std::string_view::npos);
+    EXPECT_EQ(record.message, "Flagged 1");
+}
+
+TEST_F(DebugLogLayoutTest, MessageGoesLastWithoutPlaceholder) {
+    SetPattern("%l| ");
+    Debug::Log("Trailing");
+
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    EXPECT_EQ(m_sink->retained[0]->text, "LOG| Trailing");
+    EXPECT_EQ(m_sink->retained[0]->message, "Trailing");
+}
+
+TEST_F(DebugLogLayoutTest, DeferredRecordsGetTheSuffix) {
+    SetPattern("<%v> %l", true);
+    DEBUG_LOG("Packed {}", 7);
+    Debug::Span span("timed");
+    span.End();
+    Debug::Shutdown();
+
+    ASSERT_EQ(m_sink->retained.size(), 2u);
+    EXPECT_EQ(m_sink->retained[0]->text, "<Packed 7> LOG");
+    EXPECT_EQ(m_sink->retained[0]->message, "Packed 7");
+    EXPECT_EQ(m_sink->retained[1]->text.rfind("<timed took ", 0), 0u);
+}
+
+TEST_F(DebugLogLayoutTest, InvalidPatternChangesNothing) {
+    SetPattern("%l %v");
+    EXPECT_THROW(SetPattern("%q %v"), std::runtime_error);
+    EXPECT_THROW(SetPattern("%v %v"), std::runtime_error);
+    EXPECT_THROW(SetPattern("%v %"), std::runtime_error);
+
+    Debug::Log("Still compact");
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    EXPECT_EQ(m_sink->retained[0]->text, "LOG Still compact");
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <DebugLogSinks.h>
+#include "TestSinks.h"
+
+namespace fs = std::filesystem;
+
+class DebugLogLazyTest : public RetainingSinkTest {
+protected:
+    static void SetMinLevel(const Debug::LogLevel level) {
+        Debug::Settings settings;
+        settings.minLevel = level;
+        Debug::SetSettings(settings);
+    }
+};
+
+TEST_F(DebugLogLazyTest, LazyArgumentsRunOnlyWhenEnabled) {
+    int calls = 0;
+    const auto expensive = Debug::Lazy([&calls] {
+        ++calls;
+        return std::string("computed");
+    });
+
+    Debug::Log("Value: {}", expensive);
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    EXPECT_EQ(m_sink->retained[0]->message, "Value: computed");
+    EXPECT_EQ(calls, 1);
+
+    SetMinLevel(Debug::LogLevel::WARNING_DEBUG_LOG);
+    Debug::Log("Value: {}", expensive);
+    Debug::Log(expensive);
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(m_sink->retained.size(), 1u);
+
+    Debug::LogWarning("Value: {}", expensive);
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(m_sink->retained.size(), 2u);
+}
+
+TEST_F(DebugLogLazyTest, MacrosSkipArgumentsBelowMinLevel) {
+    int evaluated = 0;
+    const auto sideEffect = [&evaluated] { return ++evaluated; };
+
+    SetMinLevel(Debug::LogLevel::ERROR_DEBUG_LOG);
+    EXPECT_FALSE(Debug::IsEnabled(Debug::LogLevel::DEFAULT_DEBUG_LOG));
+    EXPECT_FALSE(Debug::IsEnabled(Debug::LogLevel::WARNING_DEBUG_LOG));
+    EXPECT_TRUE(Debug::IsEnabled(Debug::LogLevel::ERROR_DEBUG_LOG));
+
+    DEBUG_LOG("Skipped {}", sideEffect());
+    DEBUG_LOG_WARNING("Skipped {}", sideEffect());
+    EXPECT_EQ(evaluated, 0);
+    EXPECT_TRUE(m_sink->retained.empty());
+
+    DEBUG_LOG_ERROR("Logged {}", sideEffect());
+    EXPECT_EQ(evaluated, 1);
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    EXPECT_EQ(m_sink->retained[0]->message, "Logged 1");
+}
+
+TEST_F(DebugLogLazyTest, MinLevelDropsPlainCallsAndSpans) {
+    SetMinLevel(Debug::LogLevel::WARNING_DEBUG_LOG);
+    Debug::Log("Dropped");
+    Debug::Log(42);
+    {
+        Debug::Span span("dropped");
+    }
+    Debug::LogError("Kept");
+
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    EXPECT_EQ(m_sink->retained[0]->message.rfind("Kept", 0), 0u);
+}
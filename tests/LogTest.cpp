@@ -5,6 +5,7 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <set>
 #include <DebugLog.h>
 
 namespace fs = std::filesystem;
@@ -15,9 +16,17 @@ protected:
         if (fs::exists("logs")) {
             fs::remove_all("logs");
         }
+
+        // Records reach the files only through the writer thread and its
+        // buffers; each test waits for them with Debug::Flush().
+        Debug::Settings settings;
+        settings.asynchronous = true;
+        settings.flushOnEveryWrite = false;
+        Debug::SetSettings(settings);
     }
 
     void TearDown() override {
+        Debug::SetSettings({});
         Debug::Shutdown();
 
         if (fs::exists("logs")) {
@@ -35,6 +44,7 @@ protected:
 
 TEST_F(DebugLogTest, CreatesLogDirectoriesAndFiles) {
     Debug::Log("Hello log system");
+    Debug::Flush();
 
     ASSERT_TRUE(fs::exists("logs/all")) << "logs/all should exist";
     ASSERT_TRUE(fs::exists("logs/errors")) << "logs/errors should exist";
@@ -48,6 +58,7 @@ TEST_F(DebugLogTest, CreatesLogDirectoriesAndFiles) {
 
 TEST_F(DebugLogTest, WritesToAllLog) {
     Debug::Log("Message A");
+    Debug::Flush();
 
     auto allLogs = *fs::directory_iterator("logs/all");
     std::string content = ReadFile(allLogs.path());
@@ -57,6 +68,7 @@ TEST_F(DebugLogTest, WritesToAllLog) {
 
 TEST_F(DebugLogTest, WritesWarningToAllAndErrorLogs) {
     Debug::LogWarning("Warning message");
+    Debug::Flush();
 
     auto allLogs = *fs::directory_iterator("logs/all");
     auto errLogs = *fs::directory_iterator("logs/errors");
@@ -70,6 +82,7 @@ TEST_F(DebugLogTest, WritesWarningToAllAndErrorLogs) {
 
 TEST_F(DebugLogTest, WritesErrorToAllAndErrorLogs) {
     Debug::LogError("Error message");
+    Debug::Flush();
 
     auto allLogs = *fs::directory_iterator("logs/all");
     auto errLogs = *fs::directory_iterator("logs/errors");
@@ -104,6 +117,8 @@ TEST_F(DebugLogTest, ThreadSafetyTest) {
         }
     }
 
+    Debug::Flush();
+
     const auto allLogs = *fs::directory_iterator("logs/all");
     std::string content = ReadFile(allLogs.path());
 
@@ -124,6 +139,7 @@ protected:
     }
 
     void TearDown() override {
+        Debug::SetSettings({});
         Debug::Shutdown();
         Cleanup();
     }
@@ -218,6 +234,123 @@ TEST_F(DebugLogSettingsTest, ThresholdMessageStaysInOldFile) {
     EXPECT_TRUE(foundNextInNew);
 }
 
+TEST_F(DebugLogSettingsTest, RotationWithinOneSecondCreatesBoundedSegments) {
+    Debug::Settings settings;
+    settings.rootPath = "";
+    settings.maxFileSize = 200;
+    settings.maxLogFilesAmount = 1000;
+    settings.deleteLogsAfter = 3600;
+    Debug::SetSettings(settings);
+
+    constexpr int kMessages = 100;
+    for (int i = 0; i < kMessages; ++i) {
+        Debug::Log("Rotating message {:03}", i);
+    }
+    Debug::Shutdown();
+
+    int fileCount = 0;
+    int messageCount = 0;
+    std::set<std::string> names;
+    for (const auto& entry : fs::directory_iterator("logs/all")) {
+        fileCount++;
+        names.insert(entry.path().filename().string());
+        EXPECT_LE(fs::file_size(entry.path()), settings.maxFileSize);
+
+        const std::string content = ReadFile(entry.path());
+        for (size_t pos = content.find("Rotating message"); pos != std::string::npos; pos = content.find("Rotating message", pos + 1)) {
+            messageCount++;
+        }
+    }
+
+    EXPECT_GT(fileCount, 10);
+    EXPECT_EQ(messageCount, kMessages);
+
+    // Names sort in the order the segments were written.
+    const std::string first = ReadFile(fs::path("logs/all") / *names.begin());
+    const std::string last = ReadFile(fs::path("logs/all") / *names.rbegin());
+    EXPECT_NE(first.find("Rotating message 000"), std::string::npos);
+    EXPECT_NE(last.find("Rotating message 099"), std::string::npos);
+}
+
+TEST_F(DebugLogSettingsTest, RetentionOrdersSegmentsWithinTheSameSecond) {
+    Debug::Settings settings;
+    settings.rootPath = "";
+    settings.maxFileSize = 60;
+    settings.maxLogFilesAmount = 3;
+    settings.deleteLogsAfter = 3600;
+    Debug::SetSettings(settings);
+
+    for (int i = 0; i < 20; ++i) {
+        Debug::Log("Retained message {:02}", i);
+    }
+    Debug::Shutdown();
+
+    std::string content;
+    int fileCount = 0;
+    for (const auto& entry : fs::directory_iterator("logs/all")) {
+        fileCount++;
+        content += ReadFile(entry.path());
+    }
+
+    EXPECT_EQ(fileCount, 3);
+    EXPECT_NE(content.find("Retained message 19"), std::string::npos) << "The newest segments are kept";
+    EXPECT_EQ(content.find("Retained message 00"), std::string::npos);
+}
+
+TEST_F(DebugLogSettingsTest, HourlyRotationStartsSegmentAtBoundary) {
+    Debug::Settings settings;
+    settings.rootPath = "";
+    settings.maxFileSize = 10;
+    settings.maxLogFilesAmount = 100;
+    settings.deleteLogsAfter = 3600 * 24;
+    settings.rotationPolicy = Debug::RotationPolicy::HOURLY_ROTATION;
+    Debug::SetSettings(settings);
+
+    // Time-only rotation ignores maxFileSize.
+    Debug::Log("First line of the hour");
+    Debug::Log("Second line of the hour");
+
+    const auto nextHour = std::chrono::system_clock::now() + std::chrono::hours(1);
+    Debug::Forward(Debug::LogLevel::DEFAULT_DEBUG_LOG, nextHour, "[LOG     later] Line of the next hour");
+    Debug::Shutdown();
+
+    std::vector<std::string> contents;
+    for (const auto& entry : fs::directory_iterator("logs/all")) {
+        contents.push_back(ReadFile(entry.path()));
+    }
+
+    ASSERT_EQ(contents.size(), 2u);
+    for (const auto& content : contents) {
+        const bool current = content.find("First line of the hour") != std::string::npos;
+        EXPECT_EQ(current, content.find("Second line of the hour") != std::string::npos);
+        EXPECT_NE(current, content.find("Line of the next hour") != std::string::npos);
+    }
+}
+
+TEST_F(DebugLogSettingsTest, HybridRotationRotatesOnSizeOrTime) {
+    Debug::Settings settings;
+    settings.rootPath = "";
+    settings.maxFileSize = 100;
+    settings.maxLogFilesAmount = 100;
+    settings.deleteLogsAfter = 3600 * 48;
+    settings.rotationPolicy = Debug::RotationPolicy::SIZE_OR_DAILY_ROTATION;
+    Debug::SetSettings(settings);
+
+    Debug::Log("Short line");
+    Debug::Log("Another line that no longer fits in the segment");
+
+    const auto tomorrow = std::chrono::system_clock::now() + std::chrono::hours(24);
+    Debug::Forward(Debug::LogLevel::DEFAULT_DEBUG_LOG, tomorrow, "[LOG     later] Tomorrow");
+    Debug::Shutdown();
+
+    int fileCount = 0;
+    for (const auto& entry : fs::directory_iterator("logs/all")) {
+        fileCount++;
+        EXPECT_LE(fs::file_size(entry.path()), settings.maxFileSize);
+    }
+    EXPECT_EQ(fileCount, 3);
+}
+
 TEST_F(DebugLogSettingsTest, DeletesOldLogsBasedOnTime) {
     fs::path logDir = "logs/all";
 
@@ -284,4 +417,69 @@ TEST_F(DebugLogSettingsTest, EnforcesMaxLogFilesAmount) {
 
     EXPECT_FALSE(keptOldest) << "Oldest file should have been removed";
     EXPECT_TRUE(keptNewestDummy) << "Newest dummy file should have been kept";
-}
\ No newline at end of file
+}
+
+TEST_F(DebugLogSettingsTest, AsynchronousModeWritesEveryMessage) {
+    Debug::Settings settings;
+    settings.rootPath = "";
+    settings.maxFileSize = 1024 * 1024;
+    settings.maxLogFilesAmount = 5;
+    settings.deleteLogsAfter = 3600;
+    settings.asynchronous = true;
+    Debug::SetSettings(settings);
+
+    constexpr int kThreads = 8;
+    constexpr int kMessagesPerThread = 200;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([]() {
+            for (int j = 0; j < kMessagesPerThread; ++j) {
+                Debug::Log("Async message {}", j);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    Debug::Flush();
+
+    auto it = fs::directory_iterator("logs/all");
+    ASSERT_TRUE(it != fs::end(it));
+    std::string content = ReadFile(it->path());
+
+    int count = 0;
+    for (size_t pos = content.find("Async message"); pos != std::string::npos; pos = content.find("Async message", pos + 1)) {
+        count++;
+    }
+    EXPECT_EQ(count, kThreads * kMessagesPerThread);
+}
+
+TEST_F(DebugLogSettingsTest, AsynchronousModeFallsBackToSynchronousWhenArenaIsFull) {
+    Debug::Settings settings;
+    settings.rootPath = "";
+    settings.maxFileSize = 1024 * 1024;
+    settings.maxLogFilesAmount = 5;
+    settings.deleteLogsAfter = 3600;
+    settings.asynchronous = true;
+    settings.asyncMemoryLimit = 0;
+    Debug::SetSettings(settings);
+
+    // A fresh thread holds no partially filled slab, so nothing fits in the arena.
+    std::thread producer([]() {
+        Debug::Log("First message");
+        Debug::Log("Second message");
+    });
+    producer.join();
+
+    auto it = fs::directory_iterator("logs/all");
+    ASSERT_TRUE(it != fs::end(it));
+    std::string content = ReadFile(it->path());
+
+    const size_t first = content.find("First message");
+    const size_t second = content.find("Second message");
+    ASSERT_NE(first, std::string::npos) << "Records that do not fit in the arena are written in place";
+    ASSERT_NE(second, std::string::npos);
+    EXPECT_LT(first, second);
+}
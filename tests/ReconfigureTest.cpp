@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <DebugLogSinks.h>
+
+namespace fs = std::filesystem;
+
+class DebugLogReconfigureTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Cleanup();
+    }
+
+    void TearDown() override {
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        Cleanup();
+    }
+
+    static void Cleanup() {
+        if (fs::exists("logs")) fs::remove_all("logs");
+        if (fs::exists("moved_root")) fs::remove_all("moved_root");
+    }
+
+    static std::vector<fs::path> Segments(const fs::path& directory) {
+        std::vector<fs::path> segments;
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            if (entry.path().extension() == ".log") {
+                segments.push_back(entry.path());
+            }
+        }
+        return segments;
+    }
+
+    static std::string ReadFile(const fs::path& file) {
+        std::ifstream in(file);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+};
+
+TEST_F(DebugLogReconfigureTest, KeepsTheOpenSegmentWhenRootPathIsUnchanged) {
+    Debug::SetSettings({});
+    Debug::Log("Before");
+
+    Debug::Settings settings;
+    settings.maxFileSize = 4 * 1024 * 1024;
+    settings.maxLogFilesAmount = 3;
+    settings.minLevel = Debug::LogLevel::WARNING_DEBUG_LOG;
+    Debug::SetSettings(settings);
+    Debug::Log("Filtered");
+    Debug::LogWarning("After");
+
+    const std::vector<fs::path> segments = Segments("logs/all");
+    ASSERT_EQ(segments.size(), 1u);
+    const std::string content = ReadFile(segments[0]);
+    EXPECT_NE(content.find("Before"), std::string::npos);
+    EXPECT_EQ(content.find("Filtered"), std::string::npos);
+    EXPECT_NE(content.find("After"), std::string::npos);
+
+    EXPECT_EQ(Debug::GetSettings()->maxLogFilesAmount, 3u);
+    EXPECT_EQ(Debug::GetSettings()->minLevel, Debug::LogLevel::WARNING_DEBUG_LOG);
+}
+
+TEST_F(DebugLogReconfigureTest, LowerLimitRotatesAtTheNextLine) {
+    Debug::SetSettings({});
+    Debug::Log("First line of the segment");
+
+    Debug::Settings settings;
+    settings.maxFileSize = 16;
+    Debug::SetSettings(settings);
+    ASSERT_EQ(Segments("logs/all").size(), 1u);
+
+    Debug::Log("Second line");
+    EXPECT_EQ(Segments("logs/all").size(), 2u);
+}
+
+TEST_F(DebugLogReconfigureTest, RetentionAppliesRightAway) {
+    Debug::Settings settings;
+    settings.maxFileSize = 16;
+    Debug::SetSettings(settings);
+    for (int i = 0; i < 5; ++i) {
+        Debug::Log("Line {}", i);
+    }
+    ASSERT_EQ(Segments("logs/all").size(), 5u);
+
+    settings.maxLogFilesAmount = 2;
+    Debug::SetSettings(settings);
+    EXPECT_EQ(Segments("logs/all").size(), 2u);
+}
+
+TEST_F(DebugLogReconfigureTest, NewRootPathOpensNewFiles) {
+    Debug::SetSettings({});
+    Debug::Log("Old root");
+
+    Debug::Settings settings;
+    settings.rootPath = "moved_root";
+    Debug::SetSettings(settings);
+    Debug::Log("New root");
+
+    const std::vector<fs::path> segments = Segments("moved_root/logs/all");
+    ASSERT_EQ(segments.size(), 1u);
+    EXPECT_NE(ReadFile(segments[0]).find("New root"), std::string::npos);
+    EXPECT_EQ(ReadFile(Segments("logs/all")[0]).find("New root"), std::string::npos);
+}
+
+TEST_F(DebugLogReconfigureTest, ProducersKeepLoggingWhileSettingsChange) {
+    Debug::Settings settings;
+    settings.asynchronous = true;
+    Debug::SetSettings(settings);
+
+    constexpr int kThreads = 4;
+    constexpr int kMessagesPerThread = 500;
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < kMessagesPerThread; ++i) {
+                Debug::Log("Reconfigured message");
+            }
+        });
+    }
+
+    std::thread reconfigure([&] {
+        for (size_t i = 0; !done.load(); ++i) {
+            settings.maxLogFilesAmount = 100 + i % 2;
+            Debug::SetSettings(settings);
+        }
+    });
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    done = true;
+    reconfigure.join();
+    Debug::Shutdown();
+
+    const std::vector<fs::path> segments = Segments("logs/all");
+    ASSERT_EQ(segments.size(), 1u);
+    const std::string content = ReadFile(segments[0]);
+    int count = 0;
+    for (size_t pos = content.find("Reconfigured message"); pos != std::string::npos;
+         pos = content.find("Reconfigured message", pos + 1)) {
+        ++count;
+    }
+    EXPECT_EQ(count, kThreads * kMessagesPerThread);
+}
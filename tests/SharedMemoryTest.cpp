@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <DebugLogSharedMemory.h>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    std::string UniqueName(const std::string& suffix) {
+        return "debuglog-test." + std::to_string(getpid()) + "." + suffix;
+    }
+}
+
+TEST(DebugLogSharedMemoryRingTest, PoppedEntriesMatchPushedOnes) {
+    auto ring = Debug::SharedMemoryRing::Create(UniqueName("roundtrip"), 4096);
+    auto reader = Debug::SharedMemoryRing::Attach(ring->GetName());
+    ASSERT_NE(reader, nullptr);
+
+    const auto time = std::chrono::system_clock::now();
+    ASSERT_TRUE(ring->Push(Debug::LogLevel::WARNING_DEBUG_LOG, time, "First"));
+    ASSERT_TRUE(ring->Push(Debug::LogLevel::DEFAULT_DEBUG_LOG, time, "Second"));
+
+    Debug::SharedMemoryRing::Entry entry{};
+    ASSERT_TRUE(reader->Pop(entry));
+    EXPECT_EQ(entry.text, "First");
+    EXPECT_EQ(entry.level, Debug::LogLevel::WARNING_DEBUG_LOG);
+    EXPECT_EQ(entry.time, time);
+    ASSERT_TRUE(reader->Pop(entry));
+    EXPECT_EQ(entry.text, "Second");
+    EXPECT_FALSE(reader->Pop(entry));
+    EXPECT_TRUE(reader->IsEmpty());
+    EXPECT_EQ(reader->GetProducerPid(), getpid());
+
+    ring->Unlink();
+}
+
+TEST(DebugLogSharedMemoryRingTest, EntriesWrapAroundTheEnd) {
+    auto ring = Debug::SharedMemoryRing::Create(UniqueName("wrap"), 100);
+    auto reader = Debug::SharedMemoryRing::Attach(ring->GetName());
+    ASSERT_NE(reader, nullptr);
+
+    Debug::SharedMemoryRing::Entry entry{};
+    for (int i = 0; i < 50; ++i) {
+        const std::string text = "Entry number " + std::to_string(i);
+        ASSERT_TRUE(ring->Push(Debug::LogLevel::DEFAULT_DEBUG_LOG, std::chrono::system_clock::now(), text));
+        ASSERT_TRUE(reader->Pop(entry));
+        EXPECT_EQ(entry.text, text);
+    }
+
+    ring->Unlink();
+}
+
+TEST(DebugLogSharedMemoryRingTest, FullRingDropsAndCounts) {
+    auto ring = Debug::SharedMemoryRing::Create(UniqueName("full"), 64);
+
+    int pushed = 0;
+    while (ring->Push(Debug::LogLevel::DEFAULT_DEBUG_LOG, std::chrono::system_clock::now(), "0123456789")) {
+        pushed++;
+    }
+    EXPECT_GT(pushed, 0);
+    EXPECT_EQ(ring->GetDroppedCount(), 1u);
+
+    ring->Unlink();
+}
+
+TEST(DebugLogSharedMemoryRingTest, AttachRejectsUnknownObjects) {
+    EXPECT_EQ(Debug::SharedMemoryRing::Attach(UniqueName("missing")), nullptr);
+}
+
+class DebugLogSharedMemorySinkTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    void TearDown() override {
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+};
+
+TEST_F(DebugLogSharedMemorySinkTest, SinkWritesRenderedRecordsToItsRing) {
+    auto sink = std::make_shared<Debug::SharedMemorySink>(UniqueName("sink"), 64 * 1024);
+    Debug::AddSink(sink);
+    Debug::Log("Through shared memory {}", 1);
+    Debug::LogError("Shared failure");
+
+    auto reader = Debug::SharedMemoryRing::Attach(sink->GetRingName());
+    ASSERT_NE(reader, nullptr);
+
+    Debug::SharedMemoryRing::Entry entry{};
+    ASSERT_TRUE(reader->Pop(entry));
+    EXPECT_EQ(entry.text.rfind("[LOG", 0), 0u);
+    EXPECT_NE(entry.text.find("Through shared memory 1"), std::string_view::npos);
+    ASSERT_TRUE(reader->Pop(entry));
+    EXPECT_EQ(entry.level, Debug::LogLevel::ERROR_DEBUG_LOG);
+
+    Debug::RemoveSink(sink);
+    const std::string name = sink->GetRingName();
+    sink.reset();
+    reader.reset();
+    EXPECT_EQ(Debug::SharedMemoryRing::Attach(name), nullptr) << "A drained ring is unlinked when its sink goes away";
+}
+
+TEST_F(DebugLogSharedMemorySinkTest, RingLinesCarryTheContext) {
+    auto sink = std::make_shared<Debug::SharedMemorySink>(UniqueName("context"), 64 * 1024);
+    Debug::AddSink(sink);
+    {
+        Debug::ScopedContext context{{"tenant", "acme"}};
+        Debug::Log("Shared with context");
+    }
+
+    auto reader = Debug::SharedMemoryRing::Attach(sink->GetRingName());
+    ASSERT_NE(reader, nullptr);
+    Debug::SharedMemoryRing::Entry entry{};
+    ASSERT_TRUE(reader->Pop(entry));
+    EXPECT_NE(entry.text.find("[tenant=acme] Shared with context"), std::string_view::npos);
+
+    Debug::RemoveSink(sink);
+}
+
+TEST_F(DebugLogSharedMemorySinkTest, ForwardedLinesAreWrittenAsIs) {
+    const std::string line = "[WARNING 2020-01-01_00-00-00] From another process";
+    Debug::Forward(Debug::LogLevel::WARNING_DEBUG_LOG, std::chrono::system_clock::now(), line);
+
+    auto errors = *fs::directory_iterator("logs/errors");
+    std::ifstream in(errors.path());
+    const std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content, line + "\n");
+}
+
+#endif // !_WIN32
@@ -0,0 +1,319 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <DebugLogSinks.h>
+#include "TestSinks.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    class CapturingSink final : public Debug::Sink {
+    public:
+        explicit CapturingSink(const Debug::LogLevel minLevel = Debug::LogLevel::DEFAULT_DEBUG_LOG)
+            : Sink(minLevel) { }
+
+        void Open(const Debug::Settings&) override { opened++; }
+        void Close() override { closed++; }
+
+        void Write(const Debug::RecordBatch& records) override {
+            batches++;
+            for (const Debug::Record& record : records) {
+                messages.emplace_back(record.message);
+                levels.push_back(record.level);
+                textPointers.push_back(record.text.data());
+            }
+        }
+
+        std::vector<std::string>         messages;
+        std::vector<Debug::LogLevel>     levels;
+        std::vector<const char*>         textPointers;
+        int                              batches = 0;
+        int                              opened  = 0;
+        int                              closed  = 0;
+    };
+}
+
+class DebugLogSinkTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    void TearDown() override {
+        for (const auto& sink : m_added) {
+            Debug::RemoveSink(sink);
+        }
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    std::shared_ptr<CapturingSink> Add(const Debug::LogLevel minLevel = Debug::LogLevel::DEFAULT_DEBUG_LOG) {
+        auto sink = std::make_shared<CapturingSink>(minLevel);
+        Debug::AddSink(sink);
+        m_added.push_back(sink);
+        return sink;
+    }
+
+private:
+    std::vector<std::shared_ptr<Debug::Sink>> m_added;
+};
+
+TEST_F(DebugLogSinkTest, RegisteredSinkReceivesRecords) {
+    auto sink = Add();
+
+    Debug::Log("Routed message {}", 1);
+    Debug::LogError("Routed error");
+
+    ASSERT_EQ(sink->messages.size(), 2u);
+    EXPECT_EQ(sink->messages[0], "Routed message 1");
+    EXPECT_EQ(sink->messages[1], "Routed error");
+    EXPECT_EQ(sink->levels[1], Debug::LogLevel::ERROR_DEBUG_LOG);
+    EXPECT_GE(sink->opened, 1);
+}
+
+TEST_F(DebugLogSinkTest, SinkMinimumLevelFiltersRecords) {
+    auto sink = Add(Debug::LogLevel::WARNING_DEBUG_LOG);
+
+    Debug::Log("Filtered out");
+    Debug::LogWarning("Kept warning");
+
+    ASSERT_EQ(sink->messages.size(), 1u);
+    EXPECT_EQ(sink->messages[0], "Kept warning");
+}
+
+TEST_F(DebugLogSinkTest, RecordIsFormattedOnceForAllSinks) {
+    auto first = Add();
+    auto second = Add();
+
+    Debug::Log("Shared record");
+
+    ASSERT_EQ(first->textPointers.size(), 1u);
+    ASSERT_EQ(second->textPointers.size(), 1u);
+    EXPECT_EQ(first->textPointers[0], second->textPointers[0]);
+}
+
+TEST_F(DebugLogSinkTest, RemovedSinkIsClosedAndNoLongerWritten) {
+    auto sink = Add();
+    Debug::Log("Before removal");
+
+    Debug::RemoveSink(sink);
+    Debug::Log("After removal");
+
+    ASSERT_EQ(sink->messages.size(), 1u);
+    EXPECT_EQ(sink->messages[0], "Before removal");
+    EXPECT_EQ(sink->closed, 1);
+}
+
+TEST_F(DebugLogSinkTest, AsynchronousModeDeliversBatches) {
+    Debug::Settings settings{"", 1024 * 1024, 5, 3600};
+    settings.asynchronous = true;
+    Debug::SetSettings(settings);
+
+    auto sink = Add();
+    for (int i = 0; i < 1000; ++i) {
+        Debug::Log("Batched {}", i);
+    }
+    Debug::Shutdown();
+
+    ASSERT_EQ(sink->messages.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(sink->messages[i], "Batched " + std::to_string(i));
+    }
+    EXPECT_LE(sink->batches, 1000);
+}
+
+TEST_F(DebugLogSinkTest, BuiltInSinksAreRegisteredByDefault) {
+    const auto sinks = Debug::GetSinks();
+
+    int fileSinks = 0;
+    for (const auto& sink : sinks) {
+        if (const auto* file = dynamic_cast<const Debug::FileSink*>(sink.get())) {
+            fileSinks++;
+            if (file->GetDirectory() == fs::path("logs/errors")) {
+                EXPECT_EQ(file->GetMinLevel(), Debug::LogLevel::WARNING_DEBUG_LOG);
+            }
+        }
+    }
+    EXPECT_EQ(fileSinks, 2);
+}
+
+TEST_F(DebugLogSinkTest, RetainedRecordsOutliveWrite) {
+    auto sink = std::make_shared<RetainingSink>();
+    Debug::AddSink(sink);
+
+    for (int i = 0; i < 100; ++i) {
+        Debug::Log("Retained {}", i);
+    }
+    Debug::RemoveSink(sink);
+
+    ASSERT_EQ(sink->retained.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(sink->retained[i]->message, "Retained " + std::to_string(i));
+        EXPECT_NE(sink->retained[i]->text.find(sink->retained[i]->message), std::string_view::npos);
+    }
+}
+
+TEST_F(DebugLogSinkTest, InvalidUtf8IsSanitizedOnceForEverySink) {
+    auto sink = Add();
+
+    Debug::Log("Broken \xFF byte");
+
+    ASSERT_EQ(sink->messages.size(), 1u);
+    EXPECT_EQ(sink->messages[0], "Broken \xEF\xBF\xBD byte");
+
+    auto allLogs = *fs::directory_iterator("logs/all");
+    std::ifstream in(allLogs.path());
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_NE(content.find("Broken \xEF\xBF\xBD byte"), std::string::npos);
+}
+
+class DebugLogFlightRecorderTest : public DebugLogSinkTest {
+protected:
+    static std::vector<std::string> ReadDumps() {
+        std::vector<std::string> dumps;
+        if (!fs::exists("logs/errors")) return dumps;
+
+        for (const auto& entry : fs::directory_iterator("logs/errors")) {
+            if (entry.path().extension() != ".flight") continue;
+
+            std::ifstream in(entry.path());
+            dumps.emplace_back((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        }
+        return dumps;
+    }
+};
+
+TEST_F(DebugLogFlightRecorderTest, DumpsRecentRecordsWhenErrorIsLogged) {
+    auto recorder = std::make_shared<Debug::FlightRecorderSink>(64 * 1024);
+    Debug::AddSink(recorder);
+
+    Debug::Log("Context line 1");
+    Debug::Log("Context line 2");
+    Debug::LogError("Failure");
+
+    Debug::RemoveSink(recorder);
+
+    const auto dumps = ReadDumps();
+    ASSERT_EQ(dumps.size(), 1u);
+    EXPECT_NE(dumps[0].find("Context line 1"), std::string::npos);
+    EXPECT_NE(dumps[0].find("Context line 2"), std::string::npos);
+    EXPECT_NE(dumps[0].find("Failure"), std::string::npos);
+    EXPECT_LT(dumps[0].find("Context line 1"), dumps[0].find("Failure"));
+    EXPECT_EQ(recorder->GetRecordCount(), 0u) << "The ring is emptied after a dump";
+}
+
+TEST_F(DebugLogFlightRecorderTest, DumpKeepsTheContext) {
+    auto recorder = std::make_shared<Debug::FlightRecorderSink>(64 * 1024);
+    Debug::AddSink(recorder);
+    {
+        Debug::ScopedContext context{{"request", 7}, {"tenant", "acme"}};
+        Debug::Log("Before the failure");
+        Debug::LogError("Failure");
+    }
+    Debug::RemoveSink(recorder);
+
+    const auto dumps = ReadDumps();
+    ASSERT_EQ(dumps.size(), 1u);
+    EXPECT_NE(dumps[0].find("[request=7 tenant=acme] Before the failure"), std::string::npos);
+    EXPECT_NE(dumps[0].find("[request=7 tenant=acme] Failure"), std::string::npos);
+}
+
+TEST_F(DebugLogFlightRecorderTest, EveryDumpIsANewFile) {
+    auto recorder = std::make_shared<Debug::FlightRecorderSink>(64 * 1024);
+    Debug::AddSink(recorder);
+
+    Debug::Log("First dump");
+    Debug::DumpFlightRecorder();
+    Debug::Log("Second dump");
+    Debug::DumpFlightRecorder();
+    Debug::RemoveSink(recorder);
+
+    const auto dumps = ReadDumps();
+    ASSERT_EQ(dumps.size(), 2u);
+    EXPECT_EQ(dumps[0].find("\n["), std::string::npos) << "One record per dump";
+    EXPECT_EQ(dumps[1].find("\n["), std::string::npos) << "One record per dump";
+}
+
+TEST_F(DebugLogFlightRecorderTest, DumpsDoNotCountTowardsSegmentRetention) {
+    Debug::Settings settings;
+    settings.maxLogFilesAmount = 2;
+    Debug::SetSettings(settings);
+    auto recorder = std::make_shared<Debug::FlightRecorderSink>(64 * 1024);
+    Debug::AddSink(recorder);
+
+    Debug::LogError("Kept in its segment");
+    for (int i = 0; i < 5; ++i) {
+        Debug::Log("Dump {}", i);
+        Debug::DumpFlightRecorder();
+    }
+    Debug::RemoveSink(recorder);
+
+    size_t segments = 0;
+    for (const auto& entry : fs::directory_iterator("logs/errors")) {
+        segments += entry.path().extension() == ".log";
+    }
+    EXPECT_EQ(segments, 1u);
+    EXPECT_EQ(ReadDumps().size(), 2u) << "Dumps are retained on their own";
+}
+
+TEST_F(DebugLogFlightRecorderTest, RingKeepsOnlyTheNewestRecords) {
+    auto recorder = std::make_shared<Debug::FlightRecorderSink>(1024);
+    Debug::AddSink(recorder);
+
+    for (int i = 0; i < 200; ++i) {
+        Debug::Log("Ring entry {:03}", i);
+    }
+    EXPECT_GT(recorder->GetRecordCount(), 0u);
+    EXPECT_LT(recorder->GetRecordCount(), 200u);
+
+    Debug::DumpFlightRecorder();
+    Debug::RemoveSink(recorder);
+
+    const auto dumps = ReadDumps();
+    ASSERT_EQ(dumps.size(), 1u);
+    EXPECT_EQ(dumps[0].find("Ring entry 000"), std::string::npos);
+    EXPECT_NE(dumps[0].find("Ring entry 199"), std::string::npos);
+
+    // Every dumped line is a whole record.
+    std::istringstream lines(dumps[0]);
+    for (std::string line; std::getline(lines, line);) {
+        EXPECT_EQ(line.rfind("[LOG", 0), 0u) << line;
+    }
+}
+
+TEST_F(DebugLogFlightRecorderTest, RecorderCapturesLevelsBelowFileSinks) {
+    for (const auto& sink : Debug::GetSinks()) {
+        if (auto* file = dynamic_cast<Debug::FileSink*>(sink.get())) {
+            file->SetMinLevel(Debug::LogLevel::WARNING_DEBUG_LOG);
+        }
+    }
+    auto recorder = std::make_shared<Debug::FlightRecorderSink>(64 * 1024);
+    Debug::AddSink(recorder);
+
+    Debug::Log("Only in the recorder");
+    Debug::LogError("Failure");
+    Debug::RemoveSink(recorder);
+
+    for (const auto& sink : Debug::GetSinks()) {
+        if (auto* file = dynamic_cast<Debug::FileSink*>(sink.get())) {
+            file->SetMinLevel(file->GetDirectory() == fs::path("logs/errors")
+                ? Debug::LogLevel::WARNING_DEBUG_LOG
+                : Debug::LogLevel::DEFAULT_DEBUG_LOG);
+        }
+    }
+
+    const auto dumps = ReadDumps();
+    ASSERT_EQ(dumps.size(), 1u);
+    EXPECT_NE(dumps[0].find("Only in the recorder"), std::string::npos);
+
+    for (const auto& entry : fs::directory_iterator("logs/all")) {
+        std::ifstream in(entry.path());
+        const std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        EXPECT_EQ(content.find("Only in the recorder"), std::string::npos);
+    }
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include <DebugLogSinks.h>
+#include "TestSinks.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    struct Point {
+        int x;
+        int y;
+    };
+}
+
+template <>
+struct fmt::formatter<Point> : fmt::formatter<int> {
+    auto format(const Point& point, fmt::format_context& context) const {
+        return fmt::format_to(context.out(), "({}, {})", point.x, point.y);
+    }
+};
+
+class DebugLogSiteTest : public RetainingSinkTest {};
+
+TEST_F(DebugLogSiteTest, RegistersEachCallSiteOnce) {
+    for (int i = 0; i < 3; ++i) {
+        DEBUG_LOG("Iteration {}", i);
+    }
+    DEBUG_LOG_WARNING("Elsewhere");
+
+    ASSERT_EQ(m_sink->retained.size(), 4u);
+    const Debug::LogSite* site = m_sink->retained[0]->site;
+    ASSERT_NE(site, nullptr);
+    EXPECT_EQ(m_sink->retained[1]->site, site);
+    EXPECT_EQ(m_sink->retained[2]->site, site);
+    EXPECT_EQ(site->format, "Iteration {}");
+    EXPECT_EQ(site->level, Debug::LogLevel::DEFAULT_DEBUG_LOG);
+    EXPECT_NE(site->location.file.find("SiteTest.cpp"), std::string_view::npos);
+    EXPECT_EQ(Debug::LogSite::Find(site->id), site);
+
+    const Debug::LogSite* warning = m_sink->retained[3]->site;
+    ASSERT_NE(warning, nullptr);
+    EXPECT_NE(warning->id, site->id);
+    EXPECT_GT(warning->location.line, site->location.line);
+    EXPECT_EQ(Debug::LogSite::Find(0), nullptr);
+
+    Debug::Log("Without a site");
+    EXPECT_EQ(m_sink->retained.back()->site, nullptr);
+}
+
+TEST_F(DebugLogSiteTest, RendersPackedArguments) {
+    const std::string owned = "owned";
+    const char* pointer = "pointer";
+    DEBUG_LOG("{} {} {} {:.2f} {} {} {}", owned, std::string_view("view"), pointer, 2.5, 'c', true, static_cast<uint64_t>(1) << 40);
+    DEBUG_LOG("No arguments");
+    DEBUG_LOG("Invalid {}", std::string("\xff"));
+
+    ASSERT_EQ(m_sink->retained.size(), 3u);
+    EXPECT_EQ(m_sink->retained[0]->message, "owned view pointer 2.50 c true 1099511627776");
+    EXPECT_EQ(m_sink->retained[0]->text.rfind("[LOG     ", 0), 0u);
+    EXPECT_EQ(m_sink->retained[1]->message, "No arguments");
+    EXPECT_EQ(m_sink->retained[2]->message, "Invalid \xEF\xBF\xBD");
+}
+
+TEST_F(DebugLogSiteTest, FormatsOtherArgumentsRightAway) {
+    DEBUG_LOG("Point {}", Point{1, 2});
+    DEBUG_LOG_ERROR("Failed with {}", 7);
+
+    ASSERT_EQ(m_sink->retained.size(), 2u);
+    EXPECT_EQ(m_sink->retained[0]->message, "Point (1, 2)");
+    EXPECT_NE(m_sink->retained[0]->site, nullptr);
+    EXPECT_EQ(m_sink->retained[1]->message, "Failed with 7");
+    EXPECT_EQ(m_sink->retained[1]->site->level, Debug::LogLevel::ERROR_DEBUG_LOG);
+}
+
+TEST_F(DebugLogSiteTest, RuntimeFormatStringsAreFormattedOnEveryCall) {
+    for (int i = 0; i < 3; ++i) {
+        const std::string format = "value {} #" + std::to_string(i);
+#if (__cplusplus >= 202002L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+        DEBUG_LOG(fmt::runtime(format), i);
+#else
+        DEBUG_LOG(format, i);
+#endif
+    }
+
+    ASSERT_EQ(m_sink->retained.size(), 3u);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(m_sink->retained[i]->message, fmt::format("value {} #{}", i, i));
+    }
+    ASSERT_NE(m_sink->retained[0]->site, nullptr);
+    EXPECT_EQ(m_sink->retained[2]->site, m_sink->retained[0]->site);
+    EXPECT_TRUE(m_sink->retained[0]->site->format.empty());
+}
+
+TEST_F(DebugLogSiteTest, AsynchronousArgumentsAreCopied) {
+    Debug::Settings settings;
+    settings.asynchronous = true;
+    Debug::SetSettings(settings);
+
+    std::string value;
+    for (int i = 0; i < 100; ++i) {
+        value = "value " + std::to_string(i);
+        DEBUG_LOG("{}: {} {}", i, value, i % 2);
+    }
+    value = "overwritten";
+    Debug::Shutdown();
+
+    ASSERT_EQ(m_sink->retained.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(m_sink->retained[i]->message, fmt::format("{}: value {} {}", i, i, i % 2));
+    }
+}
+
+TEST_F(DebugLogSiteTest, CharPointersFormatAsPointersInBothModes) {
+    const char* text = "pointee";
+    for (const bool asynchronous : {false, true}) {
+        Debug::Settings settings;
+        settings.asynchronous = asynchronous;
+        Debug::SetSettings(settings);
+
+        EXPECT_NO_THROW(DEBUG_LOG("Pointer {:p} {}", text, text));
+        Debug::Shutdown();
+    }
+
+    const std::string expected = fmt::format("Pointer {:p} pointee", static_cast<const void*>(text));
+    ASSERT_EQ(m_sink->retained.size(), 2u);
+    EXPECT_EQ(m_sink->retained[0]->message, expected);
+    EXPECT_EQ(m_sink->retained[1]->message, expected);
+}
+
+TEST_F(DebugLogSiteTest, ArgumentsThatFailToFormatAreDroppedInBothModes) {
+    for (const bool asynchronous : {false, true}) {
+        Debug::Settings settings;
+        settings.asynchronous = asynchronous;
+        Debug::SetSettings(settings);
+
+        const uint64_t droppedBefore = Debug::GetStats().droppedRecords;
+        EXPECT_NO_THROW(DEBUG_LOG("Width {:{}}", 5, -1));
+        DEBUG_LOG("Width {:{}}", 5, 3);
+        Debug::Shutdown();
+        EXPECT_EQ(Debug::GetStats().droppedRecords, droppedBefore + 1) << "asynchronous: " << asynchronous;
+    }
+
+    ASSERT_EQ(m_sink->retained.size(), 2u);
+    EXPECT_EQ(m_sink->retained[0]->message, "Width   5");
+    EXPECT_EQ(m_sink->retained[1]->message, "Width   5");
+}
+
+#if !((__cplusplus >= 202002L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L))
+// Before C++20 the format is only checked when the record is rendered.
+TEST_F(DebugLogSiteTest, RecordThatFailsToRenderIsDroppedAlone) {
+    Debug::Settings settings;
+    settings.asynchronous = true;
+    Debug::SetSettings(settings);
+
+    const uint64_t droppedBefore = Debug::GetStats().droppedRecords;
+    for (int i = 0; i < 10; ++i) {
+        DEBUG_LOG("Before {}", i);
+    }
+    DEBUG_LOG("Invalid {:d}", std::string("text"));
+    for (int i = 0; i < 10; ++i) {
+        DEBUG_LOG("After {}", i);
+    }
+    Debug::Shutdown();
+
+    ASSERT_EQ(m_sink->retained.size(), 20u);
+    EXPECT_EQ(m_sink->retained[0]->message, "Before 0");
+    EXPECT_EQ(m_sink->retained[10]->message, "After 0");
+    EXPECT_EQ(Debug::GetStats().droppedRecords, droppedBefore + 1);
+}
+#endif
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <DebugLogSocket.h>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    class Receiver {
+    public:
+        explicit Receiver(const std::string& path) : m_path(path) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+            unlink(path.c_str());
+            m_socket = socket(AF_UNIX, SOCK_DGRAM, 0);
+            bind(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+
+            timeval timeout{};
+            timeout.tv_sec = 2;
+            setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        }
+
+        ~Receiver() {
+            close(m_socket);
+            unlink(m_path.c_str());
+        }
+
+        std::string Receive() const {
+            char buffer[64 * 1024];
+            const ssize_t size = recv(m_socket, buffer, sizeof(buffer), 0);
+            return size < 0 ? std::string() : std::string(buffer, static_cast<size_t>(size));
+        }
+
+    private:
+        std::string m_path;
+        int         m_socket;
+    };
+
+    std::string SocketPath() {
+        return (fs::temp_directory_path() / ("debuglog-test-" + std::to_string(getpid()) + ".sock")).string();
+    }
+
+    std::string ReadDirectory(const fs::path& directory) {
+        std::string content;
+        if (!fs::exists(directory)) return content;
+
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            std::ifstream in(entry.path());
+            content.append((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        }
+        return content;
+    }
+}
+
+class DebugLogSocketSinkTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    void TearDown() override {
+        if (m_sink) Debug::RemoveSink(m_sink);
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    std::shared_ptr<Debug::SocketSink> Add() {
+        m_sink = std::make_shared<Debug::SocketSink>(SocketPath());
+        Debug::AddSink(m_sink);
+        return m_sink;
+    }
+
+private:
+    std::shared_ptr<Debug::SocketSink> m_sink;
+};
+
+TEST_F(DebugLogSocketSinkTest, RecordsArriveAsDatagrams) {
+    const Receiver receiver(SocketPath());
+    auto sink = Add();
+
+    Debug::Log("Datagram {}", 1);
+    Debug::Log("Datagram {}", 2);
+    EXPECT_TRUE(sink->IsConnected());
+
+    const std::string first = receiver.Receive();
+    const std::string second = receiver.Receive();
+    EXPECT_EQ(first.rfind("[LOG", 0), 0u);
+    EXPECT_NE(first.find("Datagram 1"), std::string::npos);
+    EXPECT_NE(second.find("Datagram 2"), std::string::npos);
+    EXPECT_FALSE(fs::exists("logs/spill"));
+}
+
+TEST_F(DebugLogSocketSinkTest, DatagramsAndSpillCarryTheContext) {
+    auto receiver = std::make_unique<Receiver>(SocketPath());
+    auto sink = Add();
+    Debug::ScopedContext context{{"request", 42}};
+
+    Debug::Log("Sent with context");
+    EXPECT_NE(receiver->Receive().find("[request=42] Sent with context"), std::string::npos);
+
+    receiver.reset();
+    Debug::Log("Spilled with context");
+    Debug::Log("Spilled again");
+    EXPECT_NE(ReadDirectory("logs/spill").find("[request=42] Spilled again"), std::string::npos);
+}
+
+TEST_F(DebugLogSocketSinkTest, SpillsToFilesWithoutPeer) {
+    auto sink = Add();
+
+    Debug::Log("Nobody is listening");
+    EXPECT_FALSE(sink->IsConnected());
+
+    EXPECT_NE(ReadDirectory("logs/spill").find("Nobody is listening"), std::string::npos);
+}
+
+TEST_F(DebugLogSocketSinkTest, ReconnectsWhenPeerAppears) {
+    auto sink = Add();
+    Debug::Log("Before the peer");
+
+    const Receiver receiver(SocketPath());
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!sink->IsConnected() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(sink->IsConnected());
+
+    Debug::Log("After the peer");
+    EXPECT_NE(receiver.Receive().find("After the peer"), std::string::npos);
+    EXPECT_NE(ReadDirectory("logs/spill").find("Before the peer"), std::string::npos);
+}
+
+TEST_F(DebugLogSocketSinkTest, SpillsWhenPeerGoesAway) {
+    auto receiver = std::make_unique<Receiver>(SocketPath());
+    auto sink = Add();
+    Debug::Log("Peer is listening");
+    ASSERT_TRUE(sink->IsConnected());
+    EXPECT_NE(receiver->Receive().find("Peer is listening"), std::string::npos);
+
+    receiver.reset();
+    Debug::Log("Peer is gone");
+
+    EXPECT_NE(ReadDirectory("logs/spill").find("Peer is gone"), std::string::npos);
+}
+#endif // !_WIN32
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <DebugLogSinks.h>
+#include "TestSinks.h"
+
+namespace fs = std::filesystem;
+
+class DebugLogSourceLocationTest : public RetainingSinkTest {};
+
+TEST_F(DebugLogSourceLocationTest, MacrosCaptureTheCallSite) {
+    const uint32_t line = __LINE__ + 1;
+    DEBUG_LOG("At the call site {}", 1);
+
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    const Debug::SourceLocation& location = m_sink->retained[0]->location;
+    EXPECT_TRUE(location.IsKnown());
+    EXPECT_NE(location.file.find("SourceLocationTest.cpp"), std::string_view::npos);
+    EXPECT_EQ(location.line, line);
+    EXPECT_EQ(location.function, "TestBody");
+
+    // The text itself is unchanged; sinks render the location.
+    EXPECT_EQ(m_sink->retained[0]->message, "At the call site 1");
+}
+
+TEST_F(DebugLogSourceLocationTest, PlainCallsCaptureTheCallerFromCpp20) {
+    const uint32_t line = __LINE__ + 1;
+    Debug::Log("Plain {}", 1);
+    Debug::LogWarning("Plain");
+    Debug::Forward(Debug::LogLevel::DEFAULT_DEBUG_LOG, std::chrono::system_clock::now(), "[LOG     x] Forwarded");
+
+    ASSERT_EQ(m_sink->retained.size(), 3u);
+#if (__cplusplus >= 202002L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+    EXPECT_EQ(m_sink->retained[0]->location.line, line);
+    EXPECT_NE(m_sink->retained[0]->location.file.find("SourceLocationTest.cpp"), std::string_view::npos);
+    EXPECT_EQ(m_sink->retained[1]->location.line, line + 1);
+#else
+    (void)line;
+    EXPECT_FALSE(m_sink->retained[0]->location.IsKnown());
+#endif
+    EXPECT_FALSE(m_sink->retained[2]->location.IsKnown());
+}
+
+TEST_F(DebugLogSourceLocationTest, AcceptsRuntimeFormatStrings) {
+    const std::string format = "Runtime {}";
+    const uint32_t line = __LINE__ + 1;
+    Debug::Log(fmt::runtime(format), 1);
+    Debug::LogError(fmt::runtime(format), "error");
+
+    ASSERT_EQ(m_sink->retained.size(), 2u);
+    EXPECT_EQ(m_sink->retained[0]->message, "Runtime 1");
+    EXPECT_EQ(m_sink->retained[1]->message.rfind("Runtime error", 0), 0u);
+#if (__cplusplus >= 202002L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+    EXPECT_EQ(m_sink->retained[0]->location.line, line);
+    EXPECT_EQ(m_sink->retained[1]->location.line, line + 1);
+#else
+    (void)line;
+#endif
+}
+
+TEST_F(DebugLogSourceLocationTest, LayoutRendersLocationWhenEnabled) {
+    Debug::Settings settings;
+    settings.sourceLocation = true;
+    Debug::SetSettings(settings);
+
+    const uint32_t line = __LINE__ + 1;
+    DEBUG_LOG("Located");
+    Debug::Shutdown();
+
+    // Part of the line itself, so every sink gets the same text.
+    const std::string located = "SourceLocationTest.cpp:" + std::to_string(line) + ": Located";
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    EXPECT_NE(m_sink->retained[0]->text.find(located), std::string_view::npos);
+    EXPECT_EQ(m_sink->retained[0]->message, "Located");
+
+    const std::string content = ReadDirectory("logs/all");
+    const std::string expected = located + "\n";
+    ASSERT_GE(content.size(), expected.size());
+    EXPECT_EQ(content.substr(content.size() - expected.size()), expected);
+    EXPECT_EQ(content.rfind("[LOG     ", 0), 0u);
+}
+
+TEST_F(DebugLogSourceLocationTest, PatternThatPlacesTheLocationIsNotDecoratedAgain) {
+    Debug::Settings settings;
+    settings.sourceLocation = true;
+    settings.pattern = "%s:%# %v";
+    Debug::SetSettings(settings);
+
+    const uint32_t line = __LINE__ + 1;
+    DEBUG_LOG("Once");
+
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    const std::string_view text = m_sink->retained[0]->text;
+    const std::string expected = ":" + std::to_string(line) + " Once";
+    ASSERT_GE(text.size(), expected.size());
+    EXPECT_EQ(text.substr(text.size() - expected.size()), expected);
+    EXPECT_EQ(text.find("SourceLocationTest.cpp"), text.rfind("SourceLocationTest.cpp"));
+    EXPECT_EQ(m_sink->retained[0]->message, "Once");
+}
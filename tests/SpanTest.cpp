@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include <DebugLogSinks.h>
+#include "TestSinks.h"
+
+namespace fs = std::filesystem;
+
+class DebugLogSpanTest : public RetainingSinkTest {};
+
+TEST_F(DebugLogSpanTest, LogsDurationWhenScopeEnds) {
+    {
+        Debug::Span span("db.query");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        EXPECT_TRUE(m_sink->retained.empty());
+    }
+    Debug::Log("Plain line");
+
+    ASSERT_EQ(m_sink->retained.size(), 2u);
+    const Debug::Record& span = *m_sink->retained[0];
+    EXPECT_TRUE(span.IsSpan());
+    EXPECT_EQ(span.spanName, "db.query");
+    EXPECT_GE(span.spanDuration, std::chrono::milliseconds(2));
+    EXPECT_EQ(span.message.rfind("db.query took ", 0), 0u);
+    EXPECT_NE(span.message.find(" us (thread " + std::to_string(span.thread) + ")"), std::string::npos);
+    EXPECT_EQ(span.text.rfind("[LOG     ", 0), 0u);
+
+    const Debug::Record& plain = *m_sink->retained[1];
+    EXPECT_FALSE(plain.IsSpan());
+    EXPECT_EQ(plain.thread, span.thread);
+}
+
+TEST_F(DebugLogSpanTest, EndIsIdempotent) {
+    Debug::Span span("early", Debug::LogLevel::WARNING_DEBUG_LOG);
+    span.End();
+    span.End();
+
+    ASSERT_EQ(m_sink->retained.size(), 1u);
+    EXPECT_EQ(m_sink->retained[0]->level, Debug::LogLevel::WARNING_DEBUG_LOG);
+    EXPECT_EQ(m_sink->retained[0]->message.find("Stacktrace"), std::string::npos);
+}
+
+TEST_F(DebugLogSpanTest, AsynchronousSpansAreRenderedByTheWriter) {
+    Debug::Settings settings;
+    settings.asynchronous = true;
+    Debug::SetSettings(settings);
+
+    for (int i = 0; i < 100; ++i) {
+        Debug::Span span("loop");
+    }
+    Debug::Shutdown();
+
+    ASSERT_EQ(m_sink->retained.size(), 100u);
+    for (size_t i = 0; i < m_sink->retained.size(); ++i) {
+        EXPECT_EQ(m_sink->retained[i]->message.rfind("loop took ", 0), 0u);
+        EXPECT_NE(m_sink->writerThreads[i], std::this_thread::get_id());
+    }
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <DebugLog.h>
+
+namespace fs = std::filesystem;
+
+class DebugLogStatsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    void TearDown() override {
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    static std::string ReadDirectory(const fs::path& directory) {
+        std::string content;
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            std::ifstream in(entry.path());
+            content.append((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        }
+        return content;
+    }
+};
+
+TEST_F(DebugLogStatsTest, CountsRecordsAndBytesPerLevel) {
+    const Debug::Stats before = Debug::GetStats();
+    Debug::Log("Counted line");
+    Debug::Log("Counted line");
+    Debug::LogWarning("Counted warning");
+    const Debug::Stats after = Debug::GetStats();
+
+    EXPECT_EQ(after.records[0] - before.records[0], 2u);
+    EXPECT_EQ(after.records[1] - before.records[1], 1u);
+    EXPECT_EQ(after.records[2] - before.records[2], 0u);
+    EXPECT_GE(after.bytes[0] - before.bytes[0], 2 * std::string("Counted line").size());
+    EXPECT_GT(after.flushes, before.flushes);
+}
+
+TEST_F(DebugLogStatsTest, CountsRotations) {
+    Debug::Settings settings;
+    settings.maxFileSize = 100;
+    settings.maxLogFilesAmount = 100;
+    Debug::SetSettings(settings);
+
+    const Debug::Stats before = Debug::GetStats();
+    for (int i = 0; i < 10; ++i) {
+        Debug::Log("A line that fills most of a segment {}", i);
+    }
+    const Debug::Stats after = Debug::GetStats();
+
+    // Two file sinks, but only logs/all sees these lines.
+    EXPECT_GE(after.rotations - before.rotations, 5u);
+    EXPECT_GT(after.rotationNanoseconds, before.rotationNanoseconds);
+}
+
+#ifndef DISABLE_LOGGING_STACKTRACE
+TEST_F(DebugLogStatsTest, TimesStacktraceCapture) {
+    const Debug::Stats before = Debug::GetStats();
+    Debug::LogError("With a stacktrace");
+    const Debug::Stats after = Debug::GetStats();
+
+    EXPECT_EQ(after.stacktraces - before.stacktraces, 1u);
+    EXPECT_GT(after.stacktraceNanoseconds, before.stacktraceNanoseconds);
+}
+#endif
+
+TEST_F(DebugLogStatsTest, TracksQueueHighWaterMark) {
+    Debug::Settings settings;
+    settings.asynchronous = true;
+    Debug::SetSettings(settings);
+
+    for (int i = 0; i < 1000; ++i) {
+        Debug::Log("Queued line {}", i);
+    }
+    Debug::Shutdown();
+
+    EXPECT_GE(Debug::GetStats().queueHighWaterMark, 1u);
+}
+
+TEST_F(DebugLogStatsTest, WritesPeriodicStatsLine) {
+    Debug::Settings settings;
+    settings.statsInterval = 1;
+    Debug::SetSettings(settings);
+
+    Debug::Log("Before the interval");
+    EXPECT_EQ(ReadDirectory("logs/all").find("Logger stats:"), std::string::npos);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    Debug::Log("After the interval");
+    Debug::Shutdown();
+
+    const std::string content = ReadDirectory("logs/all");
+    const size_t stats = content.find("Logger stats: records ");
+    ASSERT_NE(stats, std::string::npos);
+    EXPECT_LT(content.find("After the interval"), stats);
+    EXPECT_EQ(content.find("Logger stats:", stats + 1), std::string::npos);
+}
@@ -0,0 +1,57 @@
+#ifndef DEBUG_LOG_TEST_SINKS_H
+#define DEBUG_LOG_TEST_SINKS_H
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <DebugLogSinks.h>
+
+// Keeps every record it is given, along with the thread that wrote it.
+class RetainingSink final : public Debug::Sink {
+public:
+    void Write(const Debug::RecordBatch& records) override {
+        for (const Debug::Record& record : records) {
+            retained.emplace_back(record);
+            writerThreads.push_back(std::this_thread::get_id());
+        }
+    }
+
+    std::vector<Debug::RecordPtr> retained;
+    std::vector<std::thread::id>  writerThreads;
+};
+
+// Registers a RetainingSink for each test and puts the logger back to its
+// defaults afterwards, logs/ included.
+class RetainingSinkTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (std::filesystem::exists("logs")) std::filesystem::remove_all("logs");
+        m_sink = std::make_shared<RetainingSink>();
+        Debug::AddSink(m_sink);
+    }
+
+    void TearDown() override {
+        Debug::RemoveSink(m_sink);
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        if (std::filesystem::exists("logs")) std::filesystem::remove_all("logs");
+    }
+
+    static std::string ReadDirectory(const std::filesystem::path& directory) {
+        std::string content;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            std::ifstream in(entry.path());
+            content.append((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        }
+        return content;
+    }
+
+    std::shared_ptr<RetainingSink> m_sink;
+};
+
+#endif // DEBUG_LOG_TEST_SINKS_H
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <DebugLogTrace.h>
+
+namespace fs = std::filesystem;
+
+class DebugLogTraceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (fs::exists("logs")) fs::remove_all("logs");
+        m_sink = std::make_shared<Debug::TraceSink>();
+        Debug::AddSink(m_sink);
+    }
+
+    void TearDown() override {
+        Debug::RemoveSink(m_sink);
+        Debug::SetSettings({});
+        Debug::Shutdown();
+        if (fs::exists("logs")) fs::remove_all("logs");
+    }
+
+    static std::vector<std::string> ReadSegments(const fs::path& directory) {
+        std::vector<std::string> segments;
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            if (entry.path().extension() != ".json") continue;
+            std::ifstream in(entry.path());
+            segments.emplace_back((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        }
+        return segments;
+    }
+
+    std::shared_ptr<Debug::TraceSink> m_sink;
+};
+
+TEST_F(DebugLogTraceTest, WritesSpansAndInstantEvents) {
+    {
+        Debug::Span span("db.query");
+        Debug::LogWarning("Inside \"the\" span");
+    }
+    Debug::Shutdown();
+
+    const auto segments = ReadSegments("logs/trace");
+    ASSERT_EQ(segments.size(), 1u);
+    const std::string& trace = segments[0];
+    EXPECT_EQ(trace.rfind("[\n", 0), 0u);
+
+    const size_t instant = trace.find("{\"name\":\"Inside \\\"the\\\" span\",\"ph\":\"i\"");
+    const size_t span = trace.find("{\"name\":\"db.query\",\"ph\":\"X\"");
+    ASSERT_NE(instant, std::string::npos);
+    ASSERT_NE(span, std::string::npos);
+    EXPECT_NE(trace.find("\"dur\":", span), std::string::npos);
+    EXPECT_EQ(trace.find("\"ph\":\"B\""), std::string::npos);
+
+    // Everything above was logged by this thread.
+    const auto tidAt = [&trace](const size_t event) {
+        const size_t tid = trace.find("\"tid\":", event);
+        return trace.substr(tid, trace.find_first_not_of("0123456789", tid + 6) - tid);
+    };
+    EXPECT_EQ(tidAt(span), tidAt(instant));
+    EXPECT_NE(trace.find("\"level\":\"WARNING\"", instant), std::string::npos);
+    EXPECT_EQ(trace.substr(trace.size() - 3), "},\n");
+
+    // The .log sinks keep their own files.
+    for (const auto& entry : fs::directory_iterator("logs/all")) {
+        EXPECT_EQ(entry.path().extension(), ".log");
+    }
+}
+
+TEST_F(DebugLogTraceTest, RotatesSegmentsWithHeader) {
+    Debug::Settings settings;
+    settings.maxFileSize = 256;
+    settings.maxLogFilesAmount = 100;
+    Debug::SetSettings(settings);
+
+    for (int i = 0; i < 20; ++i) {
+        Debug::Log("Event number {}", i);
+    }
+    Debug::Shutdown();
+
+    const auto segments = ReadSegments("logs/trace");
+    EXPECT_GT(segments.size(), 1u);
+    for (const std::string& segment : segments) {
+        EXPECT_EQ(segment.rfind("[\n{\"name\":", 0), 0u);
+    }
+}
+
+TEST_F(DebugLogTraceTest, RotationKeepsEachSpanInOneSegment) {
+    Debug::Settings settings;
+    settings.maxFileSize = 256;
+    settings.maxLogFilesAmount = 100;
+    Debug::SetSettings(settings);
+
+    for (int i = 0; i < 20; ++i) {
+        Debug::Span span("step");
+    }
+    Debug::Shutdown();
+
+    size_t spans = 0;
+    for (const std::string& segment : ReadSegments("logs/trace")) {
+        for (size_t at = segment.find("\"ph\":\"X\""); at != std::string::npos; at = segment.find("\"ph\":\"X\"", at + 1)) {
+            EXPECT_NE(segment.find("\"dur\":", at), std::string::npos);
+            spans++;
+        }
+    }
+    EXPECT_EQ(spans, 20u);
+}
+
+TEST_F(DebugLogTraceTest, ContextFieldsCannotRepeatArgKeys) {
+    {
+        Debug::ScopedContext context{{"level", "custom"}, {"message", "shadowed"}};
+        DEBUG_LOG("Own message");
+    }
+    Debug::Shutdown();
+
+    const auto segments = ReadSegments("logs/trace");
+    ASSERT_EQ(segments.size(), 1u);
+    const std::string& trace = segments[0];
+    EXPECT_NE(trace.find("\"args\":{\"level\":\"LOG\",\"message\":\"Own message\""), std::string::npos);
+    EXPECT_NE(trace.find("\"context\":{\"level\":\"custom\",\"message\":\"shadowed\"}}},\n"), std::string::npos);
+}
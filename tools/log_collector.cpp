@@ -0,0 +1,165 @@
+// debuglog-collector: drains the shared memory rings of every process logging
+// through Debug::SharedMemorySink on this host into one set of rotated files.
+//
+//   debuglog-collector [--root DIR] [--channel NAME] [--max-file-size BYTES]
+//                      [--max-files N] [--console]
+//
+// Runs until SIGINT or SIGTERM, then drains what is left and exits.
+
+#include <DebugLog.h>
+#include <DebugLogSharedMemory.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <signal.h>
+
+namespace {
+    std::atomic<bool> stopRequested{false};
+
+    void OnStopSignal(int) {
+        stopRequested.store(true);
+    }
+
+    struct Source {
+        std::unique_ptr<Debug::SharedMemoryRing> ring;
+        uint64_t                                 reportedDrops = 0;
+    };
+
+    bool ProducerIsAlive(const int pid) {
+        return kill(pid, 0) == 0 || errno != ESRCH;
+    }
+
+    // POSIX has no way to enumerate shared memory objects; on Linux they are
+    // the files in /dev/shm.
+    void DiscoverRings(const std::string& channel, std::map<std::string, Source>& sources) {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator("/dev/shm", error)) {
+            const std::string name = entry.path().filename().string();
+            if (name.rfind(channel + ".", 0) != 0 || sources.count(name) != 0) {
+                continue;
+            }
+
+            if (auto ring = Debug::SharedMemoryRing::Attach(name)) {
+                sources[name].ring = std::move(ring);
+            }
+        }
+    }
+
+    // Forwards at most `limit` entries so that one busy process cannot
+    // starve the others.
+    size_t Drain(Source& source, const size_t limit) {
+        Debug::SharedMemoryRing::Entry entry{};
+        size_t drained = 0;
+        while (drained < limit && source.ring->Pop(entry)) {
+            Debug::Forward(entry.level, entry.time, entry.text);
+            drained++;
+        }
+
+        const uint64_t dropped = source.ring->GetDroppedCount();
+        if (dropped != source.reportedDrops) {
+            Debug::LogWarning("Process {} dropped {} records because its ring was full",
+                              source.ring->GetProducerPid(), dropped - source.reportedDrops);
+            source.reportedDrops = dropped;
+        }
+        return drained;
+    }
+
+    void PrintUsage() {
+        std::fprintf(stderr,
+            "usage: debuglog-collector [--root DIR] [--channel NAME] [--max-file-size BYTES]\n"
+            "                          [--max-files N] [--console]\n");
+    }
+}
+
+int main(const int argc, char** argv) {
+    Debug::Settings settings{};
+    std::string channel = "debuglog";
+    bool console = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--root" && hasValue) {
+            settings.rootPath = argv[++i];
+        } else if (argument == "--channel" && hasValue) {
+            channel = argv[++i];
+        } else if (argument == "--max-file-size" && hasValue) {
+            settings.maxFileSize = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--max-files" && hasValue) {
+            settings.maxLogFilesAmount = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--console") {
+            console = true;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    if (!console) {
+        for (const auto& sink : Debug::GetSinks()) {
+            if (dynamic_cast<Debug::ConsoleSink*>(sink.get())) {
+                Debug::RemoveSink(sink);
+            }
+        }
+    }
+
+    Debug::SetSettings(settings);
+
+    std::signal(SIGINT, OnStopSignal);
+    std::signal(SIGTERM, OnStopSignal);
+
+    std::map<std::string, Source> sources;
+    auto nextDiscovery = std::chrono::steady_clock::now();
+    auto idleSleep = std::chrono::milliseconds(1);
+
+    while (true) {
+        const bool stopping = stopRequested.load();
+        const auto now = std::chrono::steady_clock::now();
+        if (stopping || now >= nextDiscovery) {
+            DiscoverRings(channel, sources);
+            nextDiscovery = now + std::chrono::milliseconds(200);
+        }
+
+        size_t drained = 0;
+        for (auto it = sources.begin(); it != sources.end();) {
+            Source& source = it->second;
+            drained += Drain(source, stopping ? SIZE_MAX : 4096);
+
+            // Gone producers leave their ring behind; it is unlinked once
+            // everything in it has been written.
+            const bool finished = source.ring->IsClosed() || !ProducerIsAlive(source.ring->GetProducerPid());
+            if (finished && source.ring->IsEmpty()) {
+                source.ring->Unlink();
+                it = sources.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        if (drained == 0) {
+            std::this_thread::sleep_for(idleSleep);
+            idleSleep = std::min(idleSleep * 2, std::chrono::milliseconds(20));
+        } else {
+            idleSleep = std::chrono::milliseconds(1);
+        }
+    }
+
+    Debug::Shutdown();
+    return 0;
+}
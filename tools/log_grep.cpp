@@ -0,0 +1,381 @@
+// debuglog-grep: searches log segments for records containing a string.
+// Segments are memory-mapped and searched by a pool of threads; matches are
+// printed whole, stack traces included, in the order they were logged.
+//
+//   debuglog-grep [--level LOG|WARNING|ERROR]... [--from TIME] [--to TIME]
+//                 [--jobs N] [--with-filename] [--] PATTERN PATH...
+//
+// A PATH is a log file or a directory searched recursively, e.g. logs/.
+// logs/errors only repeats what logs/all has and is skipped next to it.
+// TIME is local time as written in the logs, YYYY-MM-DD_HH-MM-SS. An empty
+// PATTERN matches every record that passes the filters.
+//
+// Exits with 0 when something matched, 1 when nothing did and 2 on errors.
+
+#include <DebugLog.h>
+#include <DebugLogIndex.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr size_t kChunkSize = 4 * 1024 * 1024;
+    constexpr size_t kHeaderSize = 1 + 8 + 19 + 1; // "[LEVEL   YYYY-MM-DD_HH-MM-SS]"
+    constexpr Debug::LogLevel kLevels[] = {
+        Debug::LogLevel::DEFAULT_DEBUG_LOG, Debug::LogLevel::WARNING_DEBUG_LOG, Debug::LogLevel::ERROR_DEBUG_LOG
+    };
+
+    struct Options {
+        std::string                           pattern;
+        unsigned                              levels = 0; // bit per LogLevel, 0 for all
+        std::chrono::system_clock::time_point from = std::chrono::system_clock::time_point::min();
+        std::chrono::system_clock::time_point to   = std::chrono::system_clock::time_point::max();
+        bool                                  hasFrom = false;
+        bool                                  withFilename = false;
+        unsigned                              jobs = 0;
+    };
+
+    class Mapping {
+    public:
+        explicit Mapping(const std::filesystem::path& path) {
+            const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (file < 0) return;
+
+            struct stat status{};
+            if (fstat(file, &status) == 0 && status.st_size > 0) {
+                void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+                if (data != MAP_FAILED) {
+                    madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+                    m_data = static_cast<const char*>(data);
+                    m_size = static_cast<size_t>(status.st_size);
+                }
+            }
+            close(file);
+        }
+
+        ~Mapping() {
+            if (m_data) munmap(const_cast<char*>(m_data), m_size);
+        }
+
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+
+        const char* Data() const { return m_data; }
+        size_t Size() const { return m_size; }
+
+    private:
+        const char* m_data = nullptr;
+        size_t      m_size = 0;
+    };
+
+    // Records of [begin, end) of one segment; both are record boundaries.
+    struct Task {
+        std::string              path;
+        std::shared_ptr<Mapping> mapping;
+        size_t                   begin = 0;
+        size_t                   end = 0;
+
+        std::string output;
+        bool        matched = false;
+        bool        done = false;
+    };
+
+    // First occurrence of needle in [data, data + size), or size. Compares
+    // the first and last byte of the needle at 16 positions at once and only
+    // verifies the candidates.
+    size_t Find(const char* data, const size_t size, const std::string_view needle) {
+        const size_t length = needle.size();
+        if (length == 0) return 0;
+        if (length > size) return size;
+
+        size_t position = 0;
+#if defined(__SSE2__)
+        if (length >= 2) {
+            const __m128i first = _mm_set1_epi8(needle.front());
+            const __m128i last = _mm_set1_epi8(needle.back());
+
+            for (; position + length - 1 + 16 <= size; position += 16) {
+                const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+                const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position + length - 1));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))));
+
+                while (mask != 0) {
+                    const size_t candidate = position + static_cast<size_t>(__builtin_ctz(mask));
+                    if (std::memcmp(data + candidate + 1, needle.data() + 1, length - 2) == 0) {
+                        return candidate;
+                    }
+                    mask &= mask - 1;
+                }
+            }
+        }
+#endif
+        const size_t found = std::string_view(data + position, size - position).find(needle);
+        return found == std::string_view::npos ? size : position + found;
+    }
+
+    // Level of the record starting at data, or -1 when no record starts there.
+    int ParseHeader(const char* data, const size_t size, std::chrono::system_clock::time_point& time) {
+        if (size < kHeaderSize || !Debug::LogIndex::ParseRecordTime({data, kHeaderSize}, time)) {
+            return -1;
+        }
+        switch (data[1]) {
+            case 'L': return static_cast<int>(Debug::LogLevel::DEFAULT_DEBUG_LOG);
+            case 'W': return static_cast<int>(Debug::LogLevel::WARNING_DEBUG_LOG);
+            default:  return static_cast<int>(Debug::LogLevel::ERROR_DEBUG_LOG);
+        }
+    }
+
+    // Start of the first record at or after position.
+    size_t NextRecord(const char* data, const size_t size, size_t position) {
+        std::chrono::system_clock::time_point time;
+        if (position == 0 && ParseHeader(data, size, time) >= 0) {
+            return 0;
+        }
+        position = position == 0 ? 0 : position - 1;
+
+        while (position < size) {
+            const void* newline = std::memchr(data + position, '\n', size - position);
+            if (!newline) return size;
+
+            position = static_cast<size_t>(static_cast<const char*>(newline) - data) + 1;
+            if (ParseHeader(data + position, size - position, time) >= 0) {
+                return position;
+            }
+        }
+        return size;
+    }
+
+    // Start of the record that contains position, not before begin.
+    size_t RecordContaining(const char* data, const size_t begin, const size_t end, size_t position) {
+        std::chrono::system_clock::time_point time;
+        while (position > begin) {
+            size_t lineStart = position;
+            while (lineStart > begin && data[lineStart - 1] != '\n') lineStart--;
+
+            if (ParseHeader(data + lineStart, end - lineStart, time) >= 0 || lineStart == begin) {
+                return lineStart;
+            }
+            position = lineStart - 1;
+        }
+        return begin;
+    }
+
+    void Search(Task& task, const Options& options) {
+        const char* data = task.mapping->Data();
+        const size_t end = task.end;
+
+        // Without a pattern a single level is searched for by its prefix.
+        std::string needle = options.pattern;
+        bool needleIsLevel = false;
+        if (needle.empty() && options.levels != 0 && (options.levels & (options.levels - 1)) == 0) {
+            for (const Debug::LogLevel level : kLevels) {
+                if (options.levels == 1u << static_cast<unsigned>(level)) {
+                    needle = fmt::format("[{:<8}", Debug::LogTypeToString(level));
+                }
+            }
+            needleIsLevel = true;
+        }
+
+        const auto firstSecond = options.hasFrom
+                                     ? std::chrono::floor<std::chrono::seconds>(options.from)
+                                     : std::chrono::system_clock::time_point::min();
+        const auto stopAfter = options.to < std::chrono::system_clock::time_point::max() - std::chrono::seconds(1)
+                                   ? options.to + std::chrono::seconds(1)
+                                   : options.to;
+
+        size_t position = task.begin;
+        while (position < end) {
+            size_t recordStart = position;
+            if (!needle.empty()) {
+                const size_t hit = position + Find(data + position, end - position, needle);
+                if (hit >= end) break;
+
+                recordStart = RecordContaining(data, task.begin, end, hit);
+                if (needleIsLevel && recordStart != hit) {
+                    position = hit + 1;
+                    continue;
+                }
+            }
+            size_t recordEnd = NextRecord(data, end, recordStart + 1);
+            position = recordEnd;
+
+            std::chrono::system_clock::time_point time;
+            const int level = ParseHeader(data + recordStart, recordEnd - recordStart, time);
+            if (level < 0) continue;
+            if (time > stopAfter) break;
+            if (time < firstSecond || time > options.to) continue;
+            if (options.levels != 0 && (options.levels & (1u << static_cast<unsigned>(level))) == 0) continue;
+
+            if (recordEnd > recordStart && data[recordEnd - 1] == '\n') recordEnd--;
+            if (options.withFilename) {
+                task.output += task.path;
+                task.output += ": ";
+            }
+            task.output.append(data + recordStart, recordEnd - recordStart);
+            task.output += '\n';
+            task.matched = true;
+        }
+    }
+
+    void PrintUsage() {
+        std::fprintf(stderr,
+                     "usage: debuglog-grep [--level LOG|WARNING|ERROR]... [--from TIME] [--to TIME]\n"
+                     "                     [--jobs N] [--with-filename] [--] PATTERN PATH...\n"
+                     "TIME is YYYY-MM-DD_HH-MM-SS\n");
+    }
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    std::vector<std::string> positional;
+
+    bool optionsEnded = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (optionsEnded || argument.rfind("--", 0) != 0) {
+            positional.push_back(argument);
+        } else if (argument == "--") {
+            optionsEnded = true;
+        } else if (argument == "--level" && hasValue) {
+            const std::string name = argv[++i];
+            unsigned bit = 0;
+            for (const Debug::LogLevel level : kLevels) {
+                if (name == Debug::LogTypeToString(level)) bit = 1u << static_cast<unsigned>(level);
+            }
+            if (bit == 0) {
+                PrintUsage();
+                return 2;
+            }
+            options.levels |= bit;
+        } else if (argument == "--from" && hasValue) {
+            if (!Debug::LogIndex::ParseTime(argv[++i], options.from)) {
+                PrintUsage();
+                return 2;
+            }
+            options.hasFrom = true;
+        } else if (argument == "--to" && hasValue) {
+            if (!Debug::LogIndex::ParseTime(argv[++i], options.to)) {
+                PrintUsage();
+                return 2;
+            }
+            options.to += std::chrono::seconds(1) - std::chrono::nanoseconds(1);
+        } else if (argument == "--jobs" && hasValue) {
+            options.jobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--with-filename") {
+            options.withFilename = true;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    if (positional.size() < 2) {
+        PrintUsage();
+        return 2;
+    }
+    options.pattern = positional[0];
+
+    std::vector<std::filesystem::path> segments;
+    for (size_t i = 1; i < positional.size(); ++i) {
+        if (!std::filesystem::exists(positional[i])) {
+            std::fprintf(stderr, "debuglog-grep: %s: no such file or directory\n", positional[i].c_str());
+            return 2;
+        }
+        const auto found = Debug::LogIndex::CollectSegments(positional[i]);
+        segments.insert(segments.end(), found.begin(), found.end());
+    }
+
+    // Segments are split into chunks at record boundaries so that one large
+    // file does not keep a single thread busy.
+    std::vector<std::unique_ptr<Task>> tasks;
+    for (const auto& segment : segments) {
+        auto mapping = std::make_shared<Mapping>(segment);
+        const size_t size = mapping->Size();
+        if (size == 0) continue;
+
+        size_t begin = options.hasFrom ? Debug::LogIndex::FindOffset(segment, options.from) : 0;
+        begin = std::min(begin, size);
+        while (begin < size) {
+            const size_t end = begin + kChunkSize >= size ? size : NextRecord(mapping->Data(), size, begin + kChunkSize);
+
+            auto task = std::make_unique<Task>();
+            task->path = segment.string();
+            task->mapping = mapping;
+            task->begin = begin;
+            task->end = end;
+            tasks.push_back(std::move(task));
+            begin = end;
+        }
+    }
+
+    const unsigned jobs = options.jobs > 0 ? options.jobs : std::max(1u, std::thread::hardware_concurrency());
+    // Workers run at most this far ahead of the output.
+    const size_t window = static_cast<size_t>(jobs) * 4;
+
+    std::mutex mutex;
+    std::condition_variable taskDone;
+    std::condition_variable outputAdvanced;
+    size_t nextTask = 0;
+    size_t nextOutput = 0;
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            outputAdvanced.wait(lock, [&] { return nextTask >= tasks.size() || nextTask < nextOutput + window; });
+            if (nextTask >= tasks.size()) return;
+
+            Task& task = *tasks[nextTask++];
+            lock.unlock();
+            Search(task, options);
+            lock.lock();
+
+            task.done = true;
+            taskDone.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < jobs; ++i) {
+        workers.emplace_back(worker);
+    }
+
+    bool matched = false;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        std::unique_lock<std::mutex> lock(mutex);
+        taskDone.wait(lock, [&] { return tasks[i]->done; });
+        Task task = std::move(*tasks[i]);
+        nextOutput = i + 1;
+        lock.unlock();
+        outputAdvanced.notify_all();
+
+        std::fwrite(task.output.data(), 1, task.output.size(), stdout);
+        matched |= task.matched;
+    }
+
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    return matched ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+// debuglog-index: prints the records of a log directory that were logged
+// within a time range, seeking through the .idx sidecars instead of reading
+// every segment from the start.
+//
+//   debuglog-index DIRECTORY --from TIME [--to TIME]
+//
+// TIME is local time as written in the logs, YYYY-MM-DD_HH-MM-SS. Without
+// --to the range is open-ended.
+
+#include <DebugLogIndex.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace {
+    void PrintUsage() {
+        std::fprintf(stderr, "usage: debuglog-index DIRECTORY --from YYYY-MM-DD_HH-MM-SS [--to YYYY-MM-DD_HH-MM-SS]\n");
+    }
+}
+
+int main(const int argc, char** argv) {
+    std::string directory;
+    auto from = std::chrono::system_clock::time_point::min();
+    auto to = std::chrono::system_clock::time_point::max();
+    bool hasFrom = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--from" && hasValue) {
+            hasFrom = Debug::LogIndex::ParseTime(argv[++i], from);
+            if (!hasFrom) {
+                PrintUsage();
+                return 2;
+            }
+        } else if (argument == "--to" && hasValue) {
+            if (!Debug::LogIndex::ParseTime(argv[++i], to)) {
+                PrintUsage();
+                return 2;
+            }
+            // The whole last second is part of the range.
+            to += std::chrono::seconds(1) - std::chrono::nanoseconds(1);
+        } else if (directory.empty() && argument.rfind("--", 0) != 0) {
+            directory = argument;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    if (directory.empty() || !hasFrom) {
+        PrintUsage();
+        return 2;
+    }
+
+    Debug::LogIndex::ReadRange(directory, from, to, [](const std::string_view record) {
+        std::fwrite(record.data(), 1, record.size(), stdout);
+        std::fputc('\n', stdout);
+    });
+    return 0;
+}
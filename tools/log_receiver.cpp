@@ -0,0 +1,143 @@
+// debuglog-receiver: reference peer for Debug::SocketSink. Binds a Unix
+// datagram socket and writes every received record as one line, or only
+// reports throughput.
+//
+//   debuglog-receiver --socket PATH [--output FILE] [--stats]
+//
+// Runs until SIGINT or SIGTERM.
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    constexpr size_t kBatch        = 64;
+    constexpr size_t kDatagramSize = 256 * 1024;
+
+    std::atomic<bool> stopRequested{false};
+
+    void OnStopSignal(int) {
+        stopRequested.store(true);
+    }
+
+    void PrintUsage() {
+        std::fprintf(stderr, "usage: debuglog-receiver --socket PATH [--output FILE] [--stats]\n");
+    }
+}
+
+int main(const int argc, char** argv) {
+    std::string socketPath;
+    std::string outputPath;
+    bool stats = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--socket" && hasValue) {
+            socketPath = argv[++i];
+        } else if (argument == "--output" && hasValue) {
+            outputPath = argv[++i];
+        } else if (argument == "--stats") {
+            stats = true;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        PrintUsage();
+        return 2;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    FILE* output = stdout;
+    if (!outputPath.empty()) {
+        output = std::fopen(outputPath.c_str(), "ab");
+        if (!output) {
+            std::perror("debuglog-receiver: output");
+            return 1;
+        }
+    }
+
+    const int receiver = socket(AF_UNIX, SOCK_DGRAM, 0);
+    unlink(socketPath.c_str());
+    if (receiver < 0 || bind(receiver, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        std::perror("debuglog-receiver: bind");
+        return 1;
+    }
+
+    // A short timeout lets the loop notice a stop request.
+    timeval timeout{};
+    timeout.tv_usec = 200 * 1000;
+    setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::signal(SIGINT, OnStopSignal);
+    std::signal(SIGTERM, OnStopSignal);
+
+    std::vector<char> buffers(kBatch * kDatagramSize);
+    mmsghdr messages[kBatch];
+    iovec vectors[kBatch];
+
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t truncated = 0;
+    auto reportTime = std::chrono::steady_clock::now();
+
+    while (!stopRequested.load()) {
+        for (size_t i = 0; i < kBatch; ++i) {
+            vectors[i].iov_base = buffers.data() + i * kDatagramSize;
+            vectors[i].iov_len = kDatagramSize;
+            messages[i] = mmsghdr{};
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        const int received = recvmmsg(receiver, messages, kBatch, MSG_WAITFORONE, nullptr);
+        for (int i = 0; i < received; ++i) {
+            const size_t length = messages[i].msg_len;
+            truncated += (messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+            records++;
+            bytes += length;
+
+            if (!stats) {
+                std::fwrite(vectors[i].iov_base, 1, length, output);
+                std::fputc('\n', output);
+            }
+        }
+        if (!stats && received > 0) {
+            std::fflush(output);
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (stats && now - reportTime >= std::chrono::seconds(1)) {
+            const double seconds = std::chrono::duration<double>(now - reportTime).count();
+            std::fprintf(stderr, "%.0f records/s  %.2f MiB/s  %llu truncated\n",
+                         static_cast<double>(records) / seconds,
+                         static_cast<double>(bytes) / seconds / (1024.0 * 1024.0),
+                         static_cast<unsigned long long>(truncated));
+            records = 0;
+            bytes = 0;
+            reportTime = now;
+        }
+    }
+
+    close(receiver);
+    unlink(socketPath.c_str());
+    if (output != stdout) {
+        std::fclose(output);
+    }
+    return 0;
+}